@@ -0,0 +1,109 @@
+#include "BootState.h"
+#include "RtcMemory.h"
+#include <LittleFS.h>
+#include <ArduinoLog.h>
+
+#define BOOT_STATE_MAGIC 0x42535432 // "BST2", duties scaled to BOOT_STATE_DUTY_MAX
+#define BOOT_STATE_UNSET 0xFF
+#define BOOT_STATE_DUTY_MAX 254 // 8-bit copy of the 12-bit duty; exact at off and full
+
+BootState::BootState(LedController &ledCtrl, TimeManager &timeMgr)
+    : _ledController(ledCtrl), _timeManager(timeMgr), _flashPending(false), _changedAt(0)
+{
+    memset(&_record, 0, sizeof(_record));
+    memset(_record.duty, BOOT_STATE_UNSET, sizeof(_record.duty));
+    _record.magic = BOOT_STATE_MAGIC;
+}
+
+bool BootState::begin()
+{
+    // RTC memory survives soft and watchdog resets; after power loss fall back to flash
+    Record saved;
+    bool fromRtc = ESP.rtcUserMemoryRead(RTC_BLOCK_BOOT_STATE, (uint32_t *)&saved, sizeof(saved)) && isValid(saved);
+    if (!fromRtc && !(LittleFS.begin() && readFlash(saved)))
+    {
+        Log.infoln("[Boot] No saved output state.");
+        return false;
+    }
+
+    int16_t duty[LedController::MAX_GPIO];
+    for (int pin = 0; pin < LedController::MAX_GPIO; pin++)
+    {
+        duty[pin] = saved.duty[pin] == BOOT_STATE_UNSET ? -1 : (saved.duty[pin] * LedController::PWM_RANGE + BOOT_STATE_DUTY_MAX / 2) / BOOT_STATE_DUTY_MAX;
+    }
+    _ledController.restore(duty);
+    memcpy(_record.duty, saved.duty, sizeof(_record.duty));
+
+    if (fromRtc && saved.epoch != 0)
+    {
+        _timeManager.setEpochTime(saved.epoch);
+    }
+    Log.infoln("[Boot] Restored outputs from %s at %u ms.", fromRtc ? "RTC" : "flash", (unsigned long)millis());
+    return true;
+}
+
+void BootState::loop()
+{
+    uint8_t duty[BOOT_STATE_PINS];
+    memset(duty, BOOT_STATE_UNSET, sizeof(duty));
+    for (int pin = 0; pin < LedController::MAX_GPIO; pin++)
+    {
+        int16_t target = _ledController.getTargetDuty(pin);
+        if (target >= 0)
+            duty[pin] = (target * BOOT_STATE_DUTY_MAX + LedController::PWM_RANGE / 2) / LedController::PWM_RANGE;
+    }
+    if (memcmp(duty, _record.duty, sizeof(duty)) != 0)
+    {
+        memcpy(_record.duty, duty, sizeof(duty));
+        _flashPending = true;
+        _changedAt = millis();
+    }
+
+    _record.epoch = _timeManager.isTimeValid() ? _timeManager.getEpochTime() : 0;
+    _record.checksum = checksum(_record);
+    ESP.rtcUserMemoryWrite(RTC_BLOCK_BOOT_STATE, (uint32_t *)&_record, sizeof(_record));
+
+    // Flash wears out; only copy outputs that have settled
+    if (_flashPending && millis() - _changedAt >= BOOT_STATE_FLASH_DELAY)
+    {
+        _flashPending = false;
+        writeFlash();
+    }
+}
+
+uint32_t BootState::checksum(const Record &record)
+{
+    // Everything but the checksum itself
+    return rtcChecksum(&record, offsetof(Record, checksum));
+}
+
+bool BootState::isValid(const Record &record)
+{
+    return record.magic == BOOT_STATE_MAGIC && record.checksum == checksum(record);
+}
+
+bool BootState::readFlash(Record &record)
+{
+    File file = LittleFS.open(BOOT_STATE_FILE, "r");
+    if (!file)
+        return false;
+    bool ok = file.read((uint8_t *)&record, sizeof(record)) == sizeof(record) && isValid(record);
+    file.close();
+    return ok;
+}
+
+void BootState::writeFlash()
+{
+    // The clock is meaningless after power loss, keep only the outputs
+    Record record = _record;
+    record.epoch = 0;
+    record.checksum = checksum(record);
+    File file = LittleFS.open(BOOT_STATE_FILE, "w");
+    if (!file)
+    {
+        Log.warningln("[Boot] Failed to open %s for writing.", BOOT_STATE_FILE);
+        return;
+    }
+    file.write((const uint8_t *)&record, sizeof(record));
+    file.close();
+}
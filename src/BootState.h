@@ -0,0 +1,56 @@
+#ifndef BOOT_STATE_H
+#define BOOT_STATE_H
+
+#include <Arduino.h>
+#include "LedController.h"
+#include "TimeManager.h"
+
+#define BOOT_STATE_PINS 20             // Duty slots per GPIO, padded to whole RTC blocks
+#define BOOT_STATE_FLASH_DELAY 5000    // Write the flash copy once outputs have been stable this long
+#define BOOT_STATE_FILE "/boot.bin"
+
+/**
+ * Remembers the last LED duty cycles so the next boot can drive the outputs
+ * before settings, Wi-Fi or NTP are up. The record is refreshed in RTC memory
+ * every tick (together with the UTC clock, so a warm reset keeps local time)
+ * and copied to a small LittleFS file when it changes, for power-on boots.
+ */
+class BootState
+{
+public:
+    BootState(LedController &ledCtrl, TimeManager &timeMgr);
+
+    /**
+     * @brief Restores outputs (and the clock after a warm reset). Call right
+     * after LedController::begin(), before anything slow.
+     * @return true if a saved record was applied.
+     */
+    bool begin();
+
+    /**
+     * @brief Snapshots the current outputs and clock. Run about once a second.
+     */
+    void loop();
+
+private:
+    struct Record
+    {
+        uint32_t magic;
+        uint32_t epoch; // UTC seconds, 0 when the clock was not set or in the flash copy
+        uint8_t duty[BOOT_STATE_PINS]; // 0xFF for GPIOs that were never driven; expander outputs wait for settings
+        uint32_t checksum;
+    };
+
+    LedController &_ledController;
+    TimeManager &_timeManager;
+    Record _record;
+    bool _flashPending;
+    unsigned long _changedAt;
+
+    static uint32_t checksum(const Record &record);
+    static bool isValid(const Record &record);
+    bool readFlash(Record &record);
+    void writeFlash();
+};
+
+#endif // BOOT_STATE_H
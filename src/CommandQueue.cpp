@@ -0,0 +1,40 @@
+#include "CommandQueue.h"
+#include <ArduinoLog.h>
+#include "SettingsManager.h"
+
+CommandQueue::CommandQueue() : _head(0), _tail(0), _dropped(0) {}
+
+bool CommandQueue::push(const Command &command)
+{
+    uint8_t next = (_head + 1) % COMMAND_QUEUE_SIZE;
+    if (next == _tail)
+    {
+        _dropped++;
+        Log.warningln("[Commands] Queue full, dropping command %d.", command.type);
+        delete command.settings;
+        return false;
+    }
+    _commands[_head] = command;
+    _head = next;
+    return true;
+}
+
+bool CommandQueue::pop(Command &command)
+{
+    if (isEmpty())
+        return false;
+    command = _commands[_tail];
+    _commands[_tail] = Command(); // Release the text
+    _tail = (_tail + 1) % COMMAND_QUEUE_SIZE;
+    return true;
+}
+
+bool CommandQueue::isEmpty() const
+{
+    return _head == _tail;
+}
+
+uint32_t CommandQueue::getDroppedCommands() const
+{
+    return _dropped;
+}
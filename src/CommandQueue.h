@@ -0,0 +1,62 @@
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <Arduino.h>
+
+#define COMMAND_QUEUE_SIZE 16
+
+struct DeviceSettings;
+
+enum CommandType : uint8_t
+{
+    CMD_TOGGLE_CHANNEL,      // Flip channel state
+    CMD_SET_CHANNEL,         // Set channel state and, if value >= 0, brightness
+    CMD_TOGGLE_ALL_CHANNELS, // CMD_TOGGLE_CHANNEL for every channel in one command
+    CMD_SET_ALL_CHANNELS,    // CMD_SET_CHANNEL for every channel in one command
+    CMD_ADJUST_BRIGHTNESS,   // Add value to the brightness of every channel that is on
+    CMD_SCHEDULER_ACTIVE,    // Mark a channel as driven (state) or released by its schedule
+    CMD_BIND_IR_CODE,        // Bind code to the IrActionType in value (and channel for toggles)
+    CMD_SETTINGS_CHANGED,    // Replace DeviceSettings with settings (web, upload) and reconfigure
+    CMD_RECALL_SCENE,        // Apply scene number value to every channel at once
+    CMD_SAVE_SCENE,          // Capture the channels into scene text, adding it if new
+    CMD_SCHEDULE_SCENE,      // Recall scene text daily at minute value of the day, -1 for never
+    CMD_DELETE_SCENE,        // Remove scene text
+    CMD_SET_HOSTNAME,        // Store mDNS name text once probing confirmed it
+    CMD_PERSIST              // Only save, e.g. when an IR ramp ends
+};
+
+// A single input from IR, web or scheduler. Producers never touch the LEDs or flash themselves.
+struct Command
+{
+    CommandType type;
+    uint8_t channel = 0;
+    int16_t value = -1;
+    uint64_t code = 0;
+    bool state = false;
+    bool persist = false;       // Save settings once the batch is applied
+    uint16_t transitionMs = 0;  // Fade time for the resulting LED update
+    String text;                // Scene or host name
+    DeviceSettings *settings = nullptr; // CMD_SETTINGS_CHANGED: heap copy owned by the queue, then the reducer
+};
+
+/**
+ * Fixed-size FIFO of commands consumed once per tick by StateReducer. A
+ * command dropped because the queue is full has its settings freed.
+ */
+class CommandQueue
+{
+public:
+    CommandQueue();
+    bool push(const Command &command);
+    bool pop(Command &command);
+    bool isEmpty() const;
+    uint32_t getDroppedCommands() const;
+
+private:
+    Command _commands[COMMAND_QUEUE_SIZE];
+    uint8_t _head;
+    uint8_t _tail;
+    uint32_t _dropped;
+};
+
+#endif // COMMAND_QUEUE_H
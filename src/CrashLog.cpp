@@ -0,0 +1,153 @@
+#include "CrashLog.h"
+#include "RtcMemory.h"
+#include <LittleFS.h>
+#include <ArduinoLog.h>
+
+#define CRASH_LOG_MAGIC 0x4C4F4731 // "LOG1"
+#define CRASH_LOG_FILE "/crash.log"
+#define CRASH_LOG_FILE_OLD "/crash.log.1"
+
+CrashLog::CrashLog() : _spillLength(0), _spillDropped(0), _lastSpill(0), _ready(false)
+{
+    memset(&_rtc, 0, sizeof(_rtc));
+}
+
+void CrashLog::begin()
+{
+    String header = "\n=== Boot: " + getResetSummary() + " ===\n";
+    writeFile(header.c_str(), header.length());
+
+    // Whatever the previous boot logged after its last spill is still in RTC memory
+    RtcRing previous;
+    if (ESP.rtcUserMemoryRead(RTC_BLOCK_LOG_RING, (uint32_t *)&previous, sizeof(previous)) &&
+        previous.magic == CRASH_LOG_MAGIC && previous.used <= CRASH_LOG_RTC_SIZE && previous.head < CRASH_LOG_RTC_SIZE)
+    {
+        const char marker[] = "--- Last log lines before reset ---\n";
+        writeFile(marker, sizeof(marker) - 1);
+        size_t start = (previous.head + CRASH_LOG_RTC_SIZE - previous.used) % CRASH_LOG_RTC_SIZE;
+        size_t first = min((size_t)previous.used, (size_t)(CRASH_LOG_RTC_SIZE - start));
+        writeFile(&previous.data[start], first);
+        writeFile(previous.data, previous.used - first);
+    }
+
+    _rtc.magic = CRASH_LOG_MAGIC;
+    _rtc.head = 0;
+    _rtc.used = 0;
+    saveRtcHeader();
+    _lastSpill = millis();
+    _ready = true;
+    Log.infoln("[CrashLog] Reset reason: %s", ESP.getResetReason().c_str());
+}
+
+void CrashLog::loop()
+{
+    if (_ready && millis() - _lastSpill > CRASH_LOG_SPILL_INTERVAL)
+    {
+        spill();
+    }
+}
+
+void CrashLog::append(const char *data, size_t length)
+{
+    if (!_ready)
+        return;
+
+    // RTC tail: keep only the most recent bytes
+    const char *tail = data;
+    size_t tailLength = length;
+    if (tailLength > CRASH_LOG_RTC_SIZE)
+    {
+        tail += tailLength - CRASH_LOG_RTC_SIZE;
+        tailLength = CRASH_LOG_RTC_SIZE;
+    }
+    size_t from = _rtc.head;
+    for (size_t i = 0; i < tailLength; i++)
+    {
+        _rtc.data[_rtc.head] = tail[i];
+        _rtc.head = (_rtc.head + 1) % CRASH_LOG_RTC_SIZE;
+    }
+    _rtc.used = min((size_t)CRASH_LOG_RTC_SIZE, (size_t)_rtc.used + tailLength);
+    saveRtcData(from, tailLength);
+    saveRtcHeader();
+
+    // RAM staging for the next spill. When it is full the incoming data is
+    // dropped and counted; the RTC tail above still has the newest lines.
+    if (length > CRASH_LOG_SPILL_SIZE - _spillLength)
+    {
+        _spillDropped += length;
+        return;
+    }
+    memcpy(&_spill[_spillLength], data, length);
+    _spillLength += length;
+}
+
+void CrashLog::spill()
+{
+    _lastSpill = millis();
+    if (_spillDropped > 0)
+    {
+        char note[48];
+        int len = snprintf(note, sizeof(note), "--- %lu bytes not persisted ---\n", (unsigned long)_spillDropped);
+        writeFile(note, len);
+        _spillDropped = 0;
+    }
+    if (_spillLength == 0)
+        return;
+    writeFile(_spill, _spillLength);
+    _spillLength = 0;
+    // Spilled lines are on flash now, the RTC tail only needs what comes next
+    _rtc.used = 0;
+    saveRtcHeader();
+}
+
+String CrashLog::getResetSummary()
+{
+    String summary = ESP.getResetReason();
+    rst_info *info = ESP.getResetInfoPtr();
+    if (info != nullptr && (info->reason == REASON_EXCEPTION_RST || info->reason == REASON_SOFT_WDT_RST || info->reason == REASON_WDT_RST))
+    {
+        char buffer[96];
+        snprintf(buffer, sizeof(buffer), " (exccause=%u epc1=0x%08x epc2=0x%08x epc3=0x%08x excvaddr=0x%08x depc=0x%08x)",
+                 info->exccause, info->epc1, info->epc2, info->epc3, info->excvaddr, info->depc);
+        summary += buffer;
+    }
+    return summary;
+}
+
+void CrashLog::writeFile(const char *data, size_t length)
+{
+    if (length == 0)
+        return;
+    File file = LittleFS.open(CRASH_LOG_FILE, "a");
+    if (!file)
+        return;
+    file.write((const uint8_t *)data, length);
+    size_t size = file.size();
+    file.close();
+
+    if (size > CRASH_LOG_FILE_MAX)
+    {
+        LittleFS.remove(CRASH_LOG_FILE_OLD);
+        LittleFS.rename(CRASH_LOG_FILE, CRASH_LOG_FILE_OLD);
+    }
+}
+
+void CrashLog::saveRtcHeader()
+{
+    ESP.rtcUserMemoryWrite(RTC_BLOCK_LOG_RING, (uint32_t *)&_rtc, offsetof(RtcRing, data));
+}
+
+void CrashLog::saveRtcData(size_t from, size_t length)
+{
+    // Only the 4 byte blocks covering ring bytes [from, from + length), in at most two runs
+    while (length > 0)
+    {
+        size_t run = min(length, (size_t)CRASH_LOG_RTC_SIZE - from);
+        size_t first = from & ~(size_t)3;
+        size_t end = (from + run + 3) & ~(size_t)3;
+        ESP.rtcUserMemoryWrite(RTC_BLOCK_LOG_RING + (offsetof(RtcRing, data) + first) / 4,
+                               (uint32_t *)&_rtc.data[first], end - first);
+        length -= run;
+        from = 0;
+    }
+}
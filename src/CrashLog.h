@@ -0,0 +1,54 @@
+#ifndef CRASH_LOG_H
+#define CRASH_LOG_H
+
+#include <Arduino.h>
+
+#define CRASH_LOG_RTC_SIZE 248          // Log tail kept in RTC memory
+#define CRASH_LOG_SPILL_SIZE 1024       // Lines staged in RAM between spills
+#define CRASH_LOG_SPILL_INTERVAL 60000  // Spill to flash every minute
+#define CRASH_LOG_FILE_MAX 16384        // Rotate /crash.log to /crash.log.1 past this size
+
+/**
+ * Keeps log history across resets. Every log frame is mirrored into a small
+ * ring in RTC memory (cheap, survives watchdog and exception resets) and
+ * staged in RAM for a periodic append to a rotating LittleFS file. On boot
+ * the previous RTC tail is written to the file together with the reset
+ * reason and exception info.
+ */
+class CrashLog
+{
+public:
+    CrashLog();
+
+    /**
+     * @brief Records the previous boot's log tail and reset reason.
+     * Call after LittleFS has been mounted.
+     */
+    void begin();
+    void loop();
+    void append(const char *data, size_t length);
+    void spill();
+    String getResetSummary();
+
+private:
+    struct RtcRing
+    {
+        uint32_t magic;
+        uint16_t head;
+        uint16_t used;
+        char data[CRASH_LOG_RTC_SIZE];
+    };
+
+    RtcRing _rtc;
+    char _spill[CRASH_LOG_SPILL_SIZE];
+    size_t _spillLength;
+    uint32_t _spillDropped;
+    unsigned long _lastSpill;
+    bool _ready;
+
+    void writeFile(const char *data, size_t length);
+    void saveRtcHeader();
+    void saveRtcData(size_t from, size_t length);
+};
+
+#endif // CRASH_LOG_H
@@ -0,0 +1,193 @@
+#include "DmxReceiver.h"
+#include <ArduinoLog.h>
+
+#define E131_HEADER_SIZE 126   // Root, framing and DMP layers up to the first slot
+#define ARTNET_HEADER_SIZE 18
+#define E131_OPTION_TERMINATED 0x40
+#define E131_OPTION_PREVIEW 0x80
+
+static const uint8_t E131_ACN_ID[12] = {'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0};
+
+DmxReceiver::DmxReceiver(SettingsManager &settingsMgr, LedController &ledCtrl)
+    : _settingsManager(settingsMgr), _ledController(ledCtrl), _protocol(DMX_OFF), _universe(0), _pending(false),
+      _live(false), _lastSequence(-1), _lastPacket(0), _lastApply(0), _frames(0)
+{
+    memset(_levels, 0, sizeof(_levels));
+    memset(_applied, 0, sizeof(_applied));
+}
+
+DmxProtocol DmxReceiver::parseProtocol(const String &name)
+{
+    if (name == "e131")
+        return DMX_E131;
+    if (name == "artnet")
+        return DMX_ARTNET;
+    return DMX_OFF;
+}
+
+void DmxReceiver::loop()
+{
+    const DeviceSettings &settings = _settingsManager.getSettings();
+    DmxProtocol protocol = parseProtocol(settings.dmxProtocol);
+    bool connected = WiFi.status() == WL_CONNECTED;
+    bool rebind = protocol != DMX_OFF && connected && _boundIp != WiFi.localIP();
+    if (protocol != _protocol || settings.dmxUniverse != _universe || rebind)
+    {
+        _protocol = protocol;
+        _universe = settings.dmxUniverse;
+        bind(settings);
+    }
+    if (_live && millis() - _lastPacket > DMX_TIMEOUT_MS)
+    {
+        fallback("timeout");
+    }
+    if (_protocol == DMX_OFF || !connected)
+        return;
+
+    int size;
+    while ((size = _udp.parsePacket()) > 0)
+    {
+        bool terminated = false;
+        bool accepted = _protocol == DMX_E131 ? readE131(size, settings, terminated) : readArtNet(size, settings);
+        if (terminated)
+        {
+            fallback("stream terminated");
+            return;
+        }
+        if (accepted)
+        {
+            _lastPacket = millis();
+            _pending = true;
+        }
+    }
+
+    // Rate limit: only the newest frame in each interval reaches the LEDs
+    if (_pending && millis() - _lastApply >= DMX_MIN_FRAME_MS)
+    {
+        _pending = false;
+        _lastApply = millis();
+        size_t count = min(settings.channels.size(), (size_t)DMX_MAX_CHANNELS);
+        if (!_live || memcmp(_levels, _applied, count) != 0)
+        {
+            if (!_live)
+                Log.infoln("[DMX] Live input on universe %d.", _universe);
+            _live = true;
+            _ledController.applyLevels(settings, _levels, count);
+            memcpy(_applied, _levels, count);
+            _frames++;
+        }
+    }
+}
+
+void DmxReceiver::bind(const DeviceSettings &settings)
+{
+    _udp.stop();
+    _boundIp = IPAddress();
+    _lastSequence = -1;
+    if (_live)
+        fallback("reconfigured");
+    if (_protocol == DMX_OFF || WiFi.status() != WL_CONNECTED)
+        return;
+
+    bool ok;
+    if (_protocol == DMX_E131)
+    {
+        // Every universe has its own multicast group; unicast to the device works too
+        IPAddress group(239, 255, _universe >> 8, _universe & 0xFF);
+        ok = _udp.beginMulticast(WiFi.localIP(), group, E131_PORT);
+    }
+    else
+    {
+        ok = _udp.begin(ARTNET_PORT);
+    }
+    if (ok)
+    {
+        _boundIp = WiFi.localIP();
+        Log.infoln("[DMX] Listening for %s universe %d from slot %d.", settings.dmxProtocol.c_str(), _universe, settings.dmxStartSlot);
+    }
+}
+
+bool DmxReceiver::readE131(int size, const DeviceSettings &settings, bool &terminated)
+{
+    uint8_t header[E131_HEADER_SIZE];
+    if (size < E131_HEADER_SIZE || _udp.read(header, sizeof(header)) != sizeof(header))
+        return false;
+    // Root vector 4 (E1.31 data), framing vector 2, DMP vector 2, DMX start code 0
+    if (memcmp(&header[4], E131_ACN_ID, sizeof(E131_ACN_ID)) != 0 || header[21] != 0x04 || header[43] != 0x02 ||
+        header[117] != 0x02 || header[125] != 0x00)
+        return false;
+    uint16_t universe = (header[113] << 8) | header[114];
+    if (universe != _universe || (header[112] & E131_OPTION_PREVIEW))
+        return false;
+    if (header[112] & E131_OPTION_TERMINATED)
+    {
+        terminated = true;
+        return false;
+    }
+    if (!acceptSequence(header[111]))
+        return false;
+    int slotCount = ((header[123] << 8) | header[124]) - 1;
+    return readSlots(E131_HEADER_SIZE, min(slotCount, size - E131_HEADER_SIZE), settings);
+}
+
+bool DmxReceiver::readArtNet(int size, const DeviceSettings &settings)
+{
+    uint8_t header[ARTNET_HEADER_SIZE];
+    if (size < ARTNET_HEADER_SIZE || _udp.read(header, sizeof(header)) != sizeof(header))
+        return false;
+    // OpDmx (0x5000, little-endian); other opcodes (polls, sync) are ignored
+    if (memcmp(header, "Art-Net", 8) != 0 || header[8] != 0x00 || header[9] != 0x50)
+        return false;
+    uint16_t universe = ((header[15] & 0x7F) << 8) | header[14];
+    if (universe != _universe)
+        return false;
+    // Sequence 0 means the sender doesn't sequence its packets
+    if (header[12] != 0 && !acceptSequence(header[12]))
+        return false;
+    int slotCount = (header[16] << 8) | header[17];
+    return readSlots(ARTNET_HEADER_SIZE, min(slotCount, size - ARTNET_HEADER_SIZE), settings);
+}
+
+bool DmxReceiver::acceptSequence(uint8_t sequence)
+{
+    // E1.31 6.7.2: a packet up to 20 behind the last one is out of order
+    if (_lastSequence >= 0)
+    {
+        int8_t delta = (int8_t)(sequence - (uint8_t)_lastSequence);
+        if (delta <= 0 && delta > -20)
+            return false;
+    }
+    _lastSequence = sequence;
+    return true;
+}
+
+bool DmxReceiver::readSlots(int offset, int slotCount, const DeviceSettings &settings)
+{
+    int first = max(1, (int)settings.dmxStartSlot) - 1;
+    int count = min((int)settings.channels.size(), DMX_MAX_CHANNELS);
+    if (first + count > slotCount)
+        return false;
+
+    // Skip to the first mapped slot, then read the mapped slots straight into the frame
+    uint8_t skip[64];
+    for (int remaining = first; remaining > 0;)
+    {
+        int chunk = min(remaining, (int)sizeof(skip));
+        if (_udp.read(skip, chunk) != chunk)
+            return false;
+        remaining -= chunk;
+    }
+    return _udp.read(_levels, count) == count;
+}
+
+void DmxReceiver::fallback(const char *reason)
+{
+    _pending = false;
+    _lastSequence = -1;
+    if (!_live)
+        return;
+    _live = false;
+    Log.infoln("[DMX] Live input ended (%s), restoring stored state.", reason);
+    _ledController.releaseLevels();
+    _ledController.update(_settingsManager.getSettings(), DMX_FALLBACK_FADE_MS);
+}
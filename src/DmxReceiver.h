@@ -0,0 +1,73 @@
+#ifndef DMX_RECEIVER_H
+#define DMX_RECEIVER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include "SettingsManager.h"
+#include "LedController.h"
+
+#define E131_PORT 5568
+#define ARTNET_PORT 6454
+#define DMX_MIN_FRAME_MS 20    // Apply at most 50 frames per second, newer packets replace pending ones
+#define DMX_TIMEOUT_MS 2500    // E1.31 network data loss timeout; then fall back to stored state
+#define DMX_FALLBACK_FADE_MS 500
+#define DMX_MAX_CHANNELS 16
+
+enum DmxProtocol : uint8_t
+{
+    DMX_OFF,
+    DMX_E131,
+    DMX_ARTNET
+};
+
+/**
+ * Live DMX input from sACN (E1.31, multicast per universe) or Art-Net.
+ * Channel n follows slot settings.dmxStartSlot + n of settings.dmxUniverse.
+ * Frames drive LedController directly (no settings change, no flash
+ * write), rate limited to DMX_MIN_FRAME_MS. While live, LedController
+ * keeps re-applying the last frame instead of the stored state; when the
+ * stream stops or is terminated the LEDs fade back to the stored settings.
+ */
+class DmxReceiver
+{
+public:
+    DmxReceiver(SettingsManager &settingsMgr, LedController &ledCtrl);
+
+    /**
+     * @brief Follows settings, reads pending packets and applies the newest frame when due.
+     */
+    void loop();
+    bool isLive() const { return _live; }
+    uint32_t getFrames() const { return _frames; }
+
+    static DmxProtocol parseProtocol(const String &name);
+
+private:
+    WiFiUDP _udp;
+    SettingsManager &_settingsManager;
+    LedController &_ledController;
+
+    DmxProtocol _protocol;
+    uint16_t _universe;
+    IPAddress _boundIp;
+
+    // Only the mapped slots are copied out of the UDP buffer, straight into the frame
+    uint8_t _levels[DMX_MAX_CHANNELS];
+    uint8_t _applied[DMX_MAX_CHANNELS];
+    bool _pending;
+    bool _live;
+    int16_t _lastSequence;
+    unsigned long _lastPacket;
+    unsigned long _lastApply;
+    uint32_t _frames;
+
+    void bind(const DeviceSettings &settings);
+    bool readE131(int size, const DeviceSettings &settings, bool &terminated);
+    bool readArtNet(int size, const DeviceSettings &settings);
+    bool acceptSequence(uint8_t sequence);
+    bool readSlots(int offset, int slotCount, const DeviceSettings &settings);
+    void fallback(const char *reason);
+};
+
+#endif // DMX_RECEIVER_H
@@ -0,0 +1,45 @@
+#include "GpioPwmBackend.h"
+
+GpioPwmBackend::GpioPwmBackend() : _configured(0), _frequency(LED_PWM_FREQ) {}
+
+bool GpioPwmBackend::begin()
+{
+    analogWriteFreq(_frequency);
+    analogWriteRange(LED_DUTY_MAX); // One step is about 1 us at 256 Hz, within the waveform generator's resolution
+    return true;
+}
+
+bool GpioPwmBackend::setTiming(uint16_t frequencyHz, bool staggered)
+{
+    (void)staggered;
+    uint16_t frequency = constrain(frequencyHz, GPIO_PWM_MIN_FREQ, GPIO_PWM_MAX_FREQ);
+    if (frequency == _frequency)
+        return false;
+    // Running waveforms pick the new period up with their next analogWrite()
+    _frequency = frequency;
+    analogWriteFreq(_frequency);
+    return true;
+}
+
+void GpioPwmBackend::end(uint16_t offDuty)
+{
+    // A duty of 0 or the full range parks the pin at a fixed level and stops the
+    // core's waveform, so timer1 is free for another backend
+    uint16_t level = offDuty >= LED_DUTY_MAX ? LED_DUTY_MAX : 0;
+    for (uint8_t pin = 0; pin < 17; pin++)
+    {
+        if (_configured & (1UL << pin))
+            analogWrite(pin, level);
+    }
+    _configured = 0;
+}
+
+void GpioPwmBackend::write(uint8_t output, uint16_t duty)
+{
+    if (!(_configured & (1UL << output)))
+    {
+        pinMode(output, OUTPUT);
+        _configured |= 1UL << output;
+    }
+    analogWrite(output, duty);
+}
@@ -0,0 +1,30 @@
+#ifndef GPIO_PWM_BACKEND_H
+#define GPIO_PWM_BACKEND_H
+
+#include <Arduino.h>
+#include "LedBackend.h"
+
+#define GPIO_PWM_MIN_FREQ 100
+#define GPIO_PWM_MAX_FREQ 40000
+
+/**
+ * Core analogWrite() PWM on the ESP8266's GPIOs; outputs are GPIO numbers.
+ * GPIO16 (D0) has no PWM and only switches fully on or off. The core
+ * aligns all waveforms, so staggering needs the software backend.
+ */
+class GpioPwmBackend : public LedBackend
+{
+public:
+    GpioPwmBackend();
+    bool begin() override;
+    void end(uint16_t offDuty) override;
+    bool setTiming(uint16_t frequencyHz, bool staggered) override;
+    void write(uint8_t output, uint16_t duty) override;
+    const char *name() const override { return "analogWrite"; }
+
+private:
+    uint32_t _configured; // Bit per GPIO already switched to OUTPUT
+    uint16_t _frequency;
+};
+
+#endif // GPIO_PWM_BACKEND_H
@@ -0,0 +1,108 @@
+#include "GroupControl.h"
+#include <ArduinoLog.h>
+
+GroupControl::GroupControl(CommandQueue &queue, SettingsManager &settingsMgr)
+    : _queue(queue), _settingsManager(settingsMgr), _accepted(0), _dropped(0)
+{
+    memset(_senders, 0, sizeof(_senders));
+}
+
+void GroupControl::loop()
+{
+    if (WiFi.status() != WL_CONNECTED)
+    {
+        _joinedIp = IPAddress();
+        return;
+    }
+    // (Re)join whenever the station address changes, e.g. after roaming to another network
+    if (_joinedIp != WiFi.localIP())
+    {
+        _udp.stop();
+        if (!_udp.beginMulticast(WiFi.localIP(), GROUP_MULTICAST_ADDR, GROUP_PORT))
+            return;
+        _joinedIp = WiFi.localIP();
+        Log.infoln("[Group] Listening on %s:%d, group %d.", GROUP_MULTICAST_ADDR.toString().c_str(), GROUP_PORT,
+                   _settingsManager.getSettings().groupId);
+    }
+
+    int size;
+    while ((size = _udp.parsePacket()) > 0)
+    {
+        GroupPacket packet;
+        if (size != sizeof(packet) || _udp.read((uint8_t *)&packet, sizeof(packet)) != sizeof(packet) ||
+            memcmp(packet.magic, "LBG1", 4) != 0)
+        {
+            _dropped++;
+            continue;
+        }
+        if (packet.group != GROUP_ALL && packet.group != _settingsManager.getSettings().groupId)
+            continue;
+        if (!isFresh(packet.sender, packet.sequence))
+        {
+            _dropped++;
+            continue;
+        }
+        _accepted++;
+        dispatch(packet);
+    }
+}
+
+bool GroupControl::isFresh(uint32_t sender, uint32_t sequence)
+{
+    Sender *slot = nullptr;
+    Sender *oldest = &_senders[0];
+    for (auto &entry : _senders)
+    {
+        if (entry.lastSeen != 0 && entry.id == sender)
+            slot = &entry;
+        if (entry.lastSeen == 0 || entry.lastSeen < oldest->lastSeen)
+            oldest = &entry;
+    }
+
+    if (slot && millis() - slot->lastSeen < GROUP_SENDER_EXPIRY && (int32_t)(sequence - slot->sequence) <= 0)
+    {
+        return false; // Duplicate or reordered
+    }
+    if (!slot)
+    {
+        slot = oldest;
+        slot->id = sender;
+    }
+    slot->sequence = sequence;
+    slot->lastSeen = millis() | 1; // 0 marks a free slot
+    return true;
+}
+
+void GroupControl::dispatch(const GroupPacket &packet)
+{
+    // One command per packet, whatever the channel count, so repeats and
+    // bursts can't crowd IR and web input out of the queue
+    bool allChannels = packet.channel == GROUP_ALL_CHANNELS;
+    Command command;
+    command.channel = packet.channel;
+    command.value = packet.value;
+    command.state = packet.state != 0;
+    command.persist = true;
+    command.transitionMs = packet.transitionMs;
+
+    switch (packet.command)
+    {
+    case GROUP_CMD_SET:
+        command.type = allChannels ? CMD_SET_ALL_CHANNELS : CMD_SET_CHANNEL;
+        break;
+    case GROUP_CMD_TOGGLE:
+        command.type = allChannels ? CMD_TOGGLE_ALL_CHANNELS : CMD_TOGGLE_CHANNEL;
+        break;
+    case GROUP_CMD_ADJUST:
+        // Already applies to every channel that is on
+        command.type = CMD_ADJUST_BRIGHTNESS;
+        break;
+    case GROUP_CMD_SCENE:
+        command.type = CMD_RECALL_SCENE;
+        break;
+    default:
+        Log.warningln("[Group] Unknown command %d.", packet.command);
+        return;
+    }
+    _queue.push(command);
+}
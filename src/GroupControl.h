@@ -0,0 +1,79 @@
+#ifndef GROUP_CONTROL_H
+#define GROUP_CONTROL_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include "CommandQueue.h"
+#include "SettingsManager.h"
+
+#define GROUP_MULTICAST_ADDR IPAddress(239, 255, 76, 66)
+#define GROUP_PORT 4210
+#define GROUP_ALL 0            // Packets for group 0 address every device
+#define GROUP_ALL_CHANNELS 0xFF
+#define GROUP_MAX_SENDERS 4    // Senders whose sequence numbers are tracked
+#define GROUP_SENDER_EXPIRY 60000 // Forget a quiet sender so its restart (sequence reset) is accepted
+
+// Wire format, little-endian. tools/group_send.py builds the same layout.
+struct __attribute__((packed)) GroupPacket
+{
+    char magic[4];          // "LBG1"
+    uint16_t group;
+    uint8_t command;        // GroupCommand
+    uint8_t channel;        // Channel index or GROUP_ALL_CHANNELS
+    uint32_t sender;        // Random per sender, scopes the sequence number
+    uint32_t sequence;      // Increases with every new command; repeats of a packet keep it
+    int16_t value;          // Brightness 0-100 (-1 keeps it) or brightness delta
+    uint8_t state;
+    uint8_t reserved;
+    uint16_t transitionMs;
+};
+
+enum GroupCommand : uint8_t
+{
+    GROUP_CMD_SET = 1,    // state, and brightness if value >= 0
+    GROUP_CMD_TOGGLE = 2,
+    GROUP_CMD_ADJUST = 3, // add value to the brightness of channels that are on
+    GROUP_CMD_SCENE = 4   // recall scene number value; devices keep their own scenes
+};
+
+/**
+ * Listens on a multicast group so one datagram switches every ledbar in a
+ * group at once. Packets older than or equal to the last sequence number
+ * seen from their sender are dropped, so senders can repeat a packet for
+ * loss resilience. Accepted packets become commands for the StateReducer.
+ */
+class GroupControl
+{
+public:
+    GroupControl(CommandQueue &queue, SettingsManager &settingsMgr);
+
+    /**
+     * @brief Joins the multicast group once WiFi is up and handles pending packets.
+     */
+    void loop();
+
+    uint32_t getAccepted() const { return _accepted; }
+    uint32_t getDropped() const { return _dropped; }
+
+private:
+    struct Sender
+    {
+        uint32_t id;
+        uint32_t sequence;
+        unsigned long lastSeen;
+    };
+
+    WiFiUDP _udp;
+    CommandQueue &_queue;
+    SettingsManager &_settingsManager;
+    IPAddress _joinedIp;
+    Sender _senders[GROUP_MAX_SENDERS];
+    uint32_t _accepted;
+    uint32_t _dropped;
+
+    bool isFresh(uint32_t sender, uint32_t sequence);
+    void dispatch(const GroupPacket &packet);
+};
+
+#endif // GROUP_CONTROL_H
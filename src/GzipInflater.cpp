@@ -0,0 +1,419 @@
+#include "GzipInflater.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define GZIP_MAGIC_1 0x1F
+#define GZIP_MAGIC_2 0x8B
+#define GZIP_METHOD_DEFLATE 8
+#define GZIP_FLAG_HCRC 0x02
+#define GZIP_FLAG_EXTRA 0x04
+#define GZIP_FLAG_NAME 0x08
+#define GZIP_FLAG_COMMENT 0x10
+
+static const uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                         35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                         3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                           257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                           7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+static const uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+GzipInflater::GzipInflater() : _window(nullptr)
+{
+    reset();
+}
+
+GzipInflater::~GzipInflater()
+{
+    free(_window);
+}
+
+void GzipInflater::reset()
+{
+    _output = nullptr;
+    _state = STATE_HEADER;
+    _error = nullptr;
+    _lastBlock = false;
+    _truncated = false;
+    _storedRemaining = 0;
+    _inLength = 0;
+    _inPos = 0;
+    _bitBuffer = 0;
+    _bitCount = 0;
+    _outTotal = 0;
+    _outEmitted = 0;
+    _crc = 0;
+}
+
+bool GzipInflater::begin(Output output)
+{
+    reset();
+    _output = output;
+    if (!_window)
+    {
+        _window = (uint8_t *)malloc(GZIP_WINDOW_SIZE);
+    }
+    return _window != nullptr || fail("out of memory");
+}
+
+bool GzipInflater::isGzip(const uint8_t *data, size_t length)
+{
+    return length >= 3 && data[0] == GZIP_MAGIC_1 && data[1] == GZIP_MAGIC_2 && data[2] == GZIP_METHOD_DEFLATE;
+}
+
+bool GzipInflater::write(const uint8_t *data, size_t length)
+{
+    while (length > 0 && _state != STATE_ERROR)
+    {
+        // Compact, then top up the staging buffer
+        if (_inPos > 0)
+        {
+            memmove(_in, &_in[_inPos], _inLength - _inPos);
+            _inLength -= _inPos;
+            _inPos = 0;
+        }
+        size_t chunk = GZIP_INPUT_SIZE - _inLength;
+        if (chunk > length)
+            chunk = length;
+        memcpy(&_in[_inLength], data, chunk);
+        _inLength += chunk;
+        data += chunk;
+        length -= chunk;
+
+        if (!run(false))
+            return false;
+    }
+    return _state != STATE_ERROR && flush();
+}
+
+bool GzipInflater::end()
+{
+    if (!run(true) || !flush())
+        return false;
+    return _state == STATE_DONE || fail("stream ended early");
+}
+
+bool GzipInflater::run(bool final)
+{
+    // Each step consumes at most GZIP_INPUT_MARGIN bytes, so it never runs dry mid-step
+    while (_state != STATE_DONE && _state != STATE_ERROR)
+    {
+        size_t available = _inLength - _inPos + _bitCount / 8;
+        if (available == 0 || (!final && available < GZIP_INPUT_MARGIN))
+            break;
+        if (!step())
+            return false;
+        if (_truncated)
+            return fail("truncated stream");
+        if (_outTotal - _outEmitted >= GZIP_FLUSH_SIZE && !flush())
+            return false;
+    }
+    return _state != STATE_ERROR;
+}
+
+bool GzipInflater::step()
+{
+    switch (_state)
+    {
+    case STATE_HEADER:
+        return readHeader();
+    case STATE_BLOCK_HEADER:
+        return readBlockHeader();
+    case STATE_STORED:
+        put(bits(8));
+        if (--_storedRemaining == 0)
+            _state = STATE_BLOCK_HEADER;
+        return true;
+    case STATE_HUFFMAN:
+        return decodeSymbol();
+    case STATE_TRAILER:
+        return readTrailer();
+    default:
+        return false;
+    }
+}
+
+bool GzipInflater::readHeader()
+{
+    if (bits(8) != GZIP_MAGIC_1 || bits(8) != GZIP_MAGIC_2 || bits(8) != GZIP_METHOD_DEFLATE)
+        return fail("not a gzip stream");
+    uint8_t flags = bits(8);
+    bits(16); // mtime
+    bits(16);
+    bits(16); // extra flags, OS
+    if (flags & GZIP_FLAG_EXTRA)
+    {
+        for (uint32_t skip = bits(16); skip > 0 && !_truncated; skip--)
+            bits(8);
+    }
+    if (flags & GZIP_FLAG_NAME)
+    {
+        while (bits(8) != 0 && !_truncated)
+            ;
+    }
+    if (flags & GZIP_FLAG_COMMENT)
+    {
+        while (bits(8) != 0 && !_truncated)
+            ;
+    }
+    if (flags & GZIP_FLAG_HCRC)
+        bits(16);
+    _state = STATE_BLOCK_HEADER;
+    return true;
+}
+
+bool GzipInflater::readBlockHeader()
+{
+    if (_lastBlock)
+    {
+        alignToByte();
+        _state = STATE_TRAILER;
+        return true;
+    }
+    _lastBlock = bits(1);
+    switch (bits(2))
+    {
+    case 0:
+    {
+        alignToByte();
+        uint16_t length = bits(16);
+        uint16_t inverted = bits(16);
+        if ((uint16_t)~length != inverted)
+            return fail("corrupt stored block");
+        _storedRemaining = length;
+        _state = length > 0 ? STATE_STORED : STATE_BLOCK_HEADER;
+        return true;
+    }
+    case 1:
+    {
+        // Fixed Huffman codes (RFC 1951 3.2.6)
+        uint8_t lengths[288 + 30];
+        memset(lengths, 8, 144);
+        memset(&lengths[144], 9, 112);
+        memset(&lengths[256], 7, 24);
+        memset(&lengths[280], 8, 8);
+        memset(&lengths[288], 5, 30);
+        buildTree(_literals, lengths, 288);
+        buildTree(_distances, &lengths[288], 30);
+        _state = STATE_HUFFMAN;
+        return true;
+    }
+    case 2:
+        if (!readDynamicTrees())
+            return false;
+        _state = STATE_HUFFMAN;
+        return true;
+    default:
+        return fail("invalid block type");
+    }
+}
+
+bool GzipInflater::readDynamicTrees()
+{
+    uint16_t literalCount = bits(5) + 257;
+    uint16_t distanceCount = bits(5) + 1;
+    uint8_t codeLengthCount = bits(4) + 4;
+    if (literalCount > 286 || distanceCount > 30)
+        return fail("corrupt block header");
+
+    uint8_t lengths[288 + 32];
+    memset(lengths, 0, 19);
+    for (uint8_t i = 0; i < codeLengthCount; i++)
+        lengths[CODE_LENGTH_ORDER[i]] = bits(3);
+    Tree codeLengths;
+    buildTree(codeLengths, lengths, 19);
+
+    uint16_t total = literalCount + distanceCount;
+    for (uint16_t i = 0; i < total && !_truncated;)
+    {
+        int symbol = decode(codeLengths);
+        if (symbol < 0)
+            return fail("corrupt code lengths");
+        if (symbol < 16)
+        {
+            lengths[i++] = symbol;
+            continue;
+        }
+        uint8_t value = 0;
+        uint8_t repeat;
+        if (symbol == 16)
+        {
+            if (i == 0)
+                return fail("corrupt code lengths");
+            value = lengths[i - 1];
+            repeat = 3 + bits(2);
+        }
+        else if (symbol == 17)
+            repeat = 3 + bits(3);
+        else
+            repeat = 11 + bits(7);
+        if (i + repeat > total)
+            return fail("corrupt code lengths");
+        while (repeat--)
+            lengths[i++] = value;
+    }
+    buildTree(_literals, lengths, literalCount);
+    buildTree(_distances, &lengths[literalCount], distanceCount);
+    return true;
+}
+
+bool GzipInflater::decodeSymbol()
+{
+    int symbol = decode(_literals);
+    if (symbol < 0)
+        return fail("corrupt data");
+    if (symbol < 256)
+    {
+        put(symbol);
+        return true;
+    }
+    if (symbol == 256)
+    {
+        _state = STATE_BLOCK_HEADER;
+        return true;
+    }
+    symbol -= 257;
+    if (symbol >= 29)
+        return fail("corrupt length");
+    uint16_t length = LENGTH_BASE[symbol] + bits(LENGTH_EXTRA[symbol]);
+
+    int distanceSymbol = decode(_distances);
+    if (distanceSymbol < 0 || distanceSymbol >= 30)
+        return fail("corrupt distance");
+    uint32_t distance = DISTANCE_BASE[distanceSymbol] + bits(DISTANCE_EXTRA[distanceSymbol]);
+    if (distance > _outTotal)
+        return fail("distance before start");
+    if (distance > GZIP_WINDOW_SIZE)
+        return fail("window too large, compress with tools/ota.py");
+
+    while (length--)
+        put(_window[(_outTotal - distance) & (GZIP_WINDOW_SIZE - 1)]);
+    return true;
+}
+
+bool GzipInflater::readTrailer()
+{
+    uint32_t crc = bits(16);
+    crc |= bits(16) << 16;
+    uint32_t size = bits(16);
+    size |= bits(16) << 16;
+    if (!flush())
+        return false;
+    if (crc != _crc)
+        return fail("CRC mismatch");
+    if (size != _outTotal)
+        return fail("length mismatch");
+    _state = STATE_DONE;
+    return true;
+}
+
+bool GzipInflater::fail(const char *error)
+{
+    if (_state != STATE_ERROR)
+    {
+        _error = error;
+        _state = STATE_ERROR;
+    }
+    return false;
+}
+
+uint32_t GzipInflater::bits(uint8_t count)
+{
+    while (_bitCount < count)
+    {
+        if (_inPos >= _inLength)
+        {
+            _truncated = true;
+            return 0;
+        }
+        _bitBuffer |= (uint32_t)_in[_inPos++] << _bitCount;
+        _bitCount += 8;
+    }
+    uint32_t value = _bitBuffer & ((1UL << count) - 1);
+    _bitBuffer >>= count;
+    _bitCount -= count;
+    return value;
+}
+
+void GzipInflater::alignToByte()
+{
+    _bitBuffer >>= _bitCount % 8;
+    _bitCount -= _bitCount % 8;
+}
+
+int GzipInflater::decode(const Tree &tree)
+{
+    // Canonical Huffman, one bit at a time (RFC 1951 3.2.2)
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (uint8_t length = 1; length < 16; length++)
+    {
+        code |= bits(1);
+        int count = tree.counts[length];
+        if (code - first < count)
+            return tree.symbols[index + code - first];
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+void GzipInflater::buildTree(Tree &tree, const uint8_t *lengths, uint16_t count)
+{
+    uint16_t offsets[16];
+    memset(tree.counts, 0, sizeof(tree.counts));
+    for (uint16_t i = 0; i < count; i++)
+        tree.counts[lengths[i]]++;
+    tree.counts[0] = 0;
+    offsets[1] = 0;
+    for (uint8_t length = 1; length < 15; length++)
+        offsets[length + 1] = offsets[length] + tree.counts[length];
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (lengths[i])
+            tree.symbols[offsets[lengths[i]]++] = i;
+    }
+}
+
+void GzipInflater::put(uint8_t value)
+{
+    _window[_outTotal & (GZIP_WINDOW_SIZE - 1)] = value;
+    _outTotal++;
+}
+
+bool GzipInflater::flush()
+{
+    // Pending output is always less than the window, so it is still intact in the ring
+    while (_outEmitted != _outTotal)
+    {
+        uint32_t start = _outEmitted & (GZIP_WINDOW_SIZE - 1);
+        uint32_t length = _outTotal - _outEmitted;
+        if (length > GZIP_WINDOW_SIZE - start)
+            length = GZIP_WINDOW_SIZE - start;
+        _crc = crc32(_crc, &_window[start], length);
+        if (!_output(&_window[start], length))
+            return fail("output rejected");
+        _outEmitted += length;
+    }
+    return true;
+}
+
+uint32_t GzipInflater::crc32(uint32_t crc, const uint8_t *data, size_t length)
+{
+    // Nibble table: 64 bytes instead of 1 KB
+    static const uint32_t TABLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+    crc = ~crc;
+    while (length--)
+    {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ TABLE[crc & 0x0F];
+        crc = (crc >> 4) ^ TABLE[crc & 0x0F];
+    }
+    return ~crc;
+}
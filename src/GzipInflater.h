@@ -0,0 +1,100 @@
+#ifndef GZIP_INFLATER_H
+#define GZIP_INFLATER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+#define GZIP_WINDOW_BITS 12                      // 4 KB history; compress with tools/ota.py (wbits 12)
+#define GZIP_WINDOW_SIZE (1 << GZIP_WINDOW_BITS)
+#define GZIP_INPUT_SIZE 1024                     // Compressed bytes staged between write() calls
+#define GZIP_INPUT_MARGIN 600                    // Enough input for the largest single decode step
+#define GZIP_FLUSH_SIZE 1024                     // Hand output on in chunks of about this size
+
+/**
+ * Streaming gzip decoder for images pushed in arbitrary chunks (HTTP
+ * uploads). Output goes to a callback as it is produced, so nothing but a
+ * small history window is held in RAM. The window is limited to
+ * GZIP_WINDOW_SIZE instead of deflate's 32 KB; streams that reach further
+ * back are rejected rather than decoded wrong. The gzip CRC32 and length
+ * trailer are checked in end().
+ */
+class GzipInflater
+{
+public:
+    // Receives decompressed data; return false to abort
+    typedef std::function<bool(const uint8_t *data, size_t length)> Output;
+
+    GzipInflater();
+    ~GzipInflater();
+
+    bool begin(Output output);
+    bool write(const uint8_t *data, size_t length);
+    bool end();
+    void reset();
+
+    // True if data starts with the gzip magic and the deflate method byte
+    static bool isGzip(const uint8_t *data, size_t length);
+
+    const char *getError() const { return _error; }
+    uint32_t getOutputSize() const { return _outTotal; }
+
+private:
+    enum State
+    {
+        STATE_HEADER,
+        STATE_BLOCK_HEADER,
+        STATE_STORED,
+        STATE_HUFFMAN,
+        STATE_TRAILER,
+        STATE_DONE,
+        STATE_ERROR
+    };
+
+    struct Tree
+    {
+        uint16_t counts[16];
+        uint16_t symbols[288];
+    };
+
+    Output _output;
+    State _state;
+    const char *_error;
+    bool _lastBlock;
+    bool _truncated;
+    uint32_t _storedRemaining;
+
+    uint8_t _in[GZIP_INPUT_SIZE];
+    size_t _inLength;
+    size_t _inPos;
+    uint32_t _bitBuffer;
+    uint8_t _bitCount;
+
+    uint8_t *_window;
+    uint32_t _outTotal;
+    uint32_t _outEmitted;
+    uint32_t _crc;
+
+    Tree _literals;
+    Tree _distances;
+
+    bool run(bool final);
+    bool step();
+    bool readHeader();
+    bool readBlockHeader();
+    bool readDynamicTrees();
+    bool decodeSymbol();
+    bool readTrailer();
+    bool fail(const char *error);
+
+    uint32_t bits(uint8_t count);
+    int decode(const Tree &tree);
+    void alignToByte();
+    void put(uint8_t value);
+    bool flush();
+
+    static void buildTree(Tree &tree, const uint8_t *lengths, uint16_t count);
+    static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t length);
+};
+
+#endif // GZIP_INFLATER_H
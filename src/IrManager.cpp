@@ -1,46 +1,233 @@
 #include "IrManager.h"
+#include <ArduinoLog.h>
 #include <IRremoteESP8266.h>
 #include <IRrecv.h>
 #include <IRutils.h>
+#include <algorithm>
 
 // Globals
 IRrecv *irrecv = nullptr;
 decode_results results;
 
-IrManager::IrManager(uint8_t irPin) : _irPin(irPin), _irAvailable(false), _irData(0) {}
+IrManager::IrManager(uint8_t irPin)
+    : _irPin(irPin), _queueHead(0), _queueTail(0), _droppedEvents(0), _lastCode(0), _lastCodeTime(0), _pressStart(0), _holding(false),
+      _learnState(IR_LEARN_IDLE), _learnResult(), _learnDeadline(0) {}
 
 void IrManager::begin()
 {
+    // IRrecv captures edges from its own pin interrupt; loop() only decodes finished frames
     irrecv = new IRrecv(_irPin);
     irrecv->enableIRIn(true);
 }
 
+// Protocols that send a short repeat frame while a key is held; their full code only comes with a new press
+static bool sendsRepeatFrames(decode_type_t protocol)
+{
+    return protocol == NEC || protocol == NEC_LIKE || protocol == LG || protocol == LG2;
+}
+
 void IrManager::loop()
 {
-    if (irrecv->decode(&results))
+    // Drain every frame the receiver has completed since the last call
+    while (irrecv->decode(&results))
     {
-        if (results.value != 0 && results.value != 0xFFFFFFFF)
+        uint32_t now = millis();
+        bool repeatFrame = results.repeat || results.value == kRepeat || results.value == 0xFFFFFFFF;
+        bool stillHeld = _holding && now - _lastCodeTime < IR_RELEASE_MS;
+        // Other protocols resend the full code at their frame interval while held, so the
+        // same code counts as held only that quickly; a fast second press stays a press
+        bool resent = results.value == _lastCode && !sendsRepeatFrames(results.decode_type) &&
+                      now - _lastCodeTime < IR_RESEND_GAP_MS;
+
+        if (repeatFrame || (stillHeld && resent))
         {
-            _irData = results.value;
-            _irAvailable = true;
-            delay(100); // Add a small delay to debounce
+            // Repeat codes (or remotes that resend the full code) extend the current press
+            if (stillHeld)
+            {
+                _lastCodeTime = now;
+                push(IR_EVENT_REPEAT, _lastCode, now);
+            }
+        }
+        else if (results.value != 0)
+        {
+            if (_holding)
+            {
+                push(IR_EVENT_RELEASE, _lastCode, _lastCodeTime);
+            }
+            _holding = true;
+            _pressStart = now;
+            _lastCode = results.value;
+            _lastCodeTime = now;
+            if (_learnState == IR_LEARN_LISTENING)
+            {
+                // Learn mode swallows the press so it does not also trigger an action
+                _learnResult.code = results.value;
+                _learnResult.protocol = results.decode_type;
+                _learnResult.bits = results.bits;
+                _learnState = IR_LEARN_CAPTURED;
+                Log.infoln("[IR] Learned code with protocol %s, %d bits.", typeToString(results.decode_type).c_str(), results.bits);
+            }
+            else
+            {
+                push(IR_EVENT_PRESS, _lastCode, now);
+            }
         }
         irrecv->resume();
     }
+
+    if (_learnState == IR_LEARN_LISTENING && (int32_t)(millis() - _learnDeadline) >= 0)
+    {
+        Log.infoln("[IR] Learn mode timed out.");
+        _learnState = IR_LEARN_TIMEOUT;
+    }
+
+    if (_holding && millis() - _lastCodeTime >= IR_RELEASE_MS)
+    {
+        _holding = false;
+        push(IR_EVENT_RELEASE, _lastCode, _lastCodeTime);
+    }
+}
+
+void IrManager::push(IrEventType type, uint64_t code, uint32_t timestamp)
+{
+    uint8_t next = (_queueHead + 1) % IR_QUEUE_SIZE;
+    if (next == _queueTail)
+    {
+        _droppedEvents++;
+        Log.warningln("[IR] Event queue full, dropping code.");
+        return;
+    }
+    IrEvent &event = _queue[_queueHead];
+    event.code = code;
+    event.timestamp = timestamp;
+    event.holdMs = timestamp - _pressStart;
+    event.type = type;
+    _queueHead = next;
 }
 
 bool IrManager::available()
 {
-    return _irAvailable;
+    return _queueHead != _queueTail;
 }
 
 uint64_t IrManager::read()
 {
-    _irAvailable = false;
-    return _irData;
+    IrEvent event;
+    return read(event) ? event.code : 0;
+}
+
+bool IrManager::read(IrEvent &event)
+{
+    if (!available())
+    {
+        return false;
+    }
+    event = _queue[_queueTail];
+    _queueTail = (_queueTail + 1) % IR_QUEUE_SIZE;
+    return true;
 }
 
 void IrManager::resume()
 {
     irrecv->resume();
 }
+
+uint32_t IrManager::getDroppedEvents() const
+{
+    return _droppedEvents;
+}
+
+void IrManager::updateBindings(const DeviceSettings &settings)
+{
+    _bindings.clear();
+    addBinding(settings.irCodeBrightnessUp, IR_ACTION_BRIGHTNESS_UP, 0);
+    addBinding(settings.irCodeBrightnessDown, IR_ACTION_BRIGHTNESS_DOWN, 0);
+    for (size_t i = 0; i < settings.channels.size(); i++)
+    {
+        addBinding(settings.channels[i].irCode, IR_ACTION_TOGGLE_CHANNEL, i);
+    }
+    for (size_t i = 0; i < settings.scenes.size(); i++)
+    {
+        addBinding(settings.scenes[i].irCode, IR_ACTION_RECALL_SCENE, i);
+    }
+    // stable_sort keeps actions for the same code in settings order
+    std::stable_sort(_bindings.begin(), _bindings.end(), [](const IrBinding &a, const IrBinding &b)
+                     { return a.code < b.code; });
+    Log.infoln("[IR] %d IR bindings compiled.", _bindings.size());
+}
+
+void IrManager::addBinding(uint64_t code, IrActionType action, uint8_t channel)
+{
+    if (code == 0)
+    {
+        return;
+    }
+    _bindings.push_back({code, action, channel});
+}
+
+size_t IrManager::lookup(uint64_t code, const IrBinding *&first) const
+{
+    auto range = std::equal_range(_bindings.begin(), _bindings.end(), IrBinding{code, IR_ACTION_TOGGLE_CHANNEL, 0},
+                                  [](const IrBinding &a, const IrBinding &b)
+                                  { return a.code < b.code; });
+    first = range.first == _bindings.end() ? nullptr : &*range.first;
+    return range.second - range.first;
+}
+
+void IrManager::formatCode(uint64_t code, char *buffer)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    char reversed[16];
+    int length = 0;
+    do
+    {
+        reversed[length++] = digits[code & 0xF];
+        code >>= 4;
+    } while (code != 0);
+    for (int i = 0; i < length; i++)
+    {
+        buffer[i] = reversed[length - 1 - i];
+    }
+    buffer[length] = '\0';
+}
+
+void IrManager::startLearning(IrActionType action, uint8_t channel, uint32_t timeoutMs)
+{
+    _learnResult = IrLearnResult();
+    _learnResult.action = action;
+    _learnResult.channel = channel;
+    _learnDeadline = millis() + timeoutMs;
+    _learnState = IR_LEARN_LISTENING;
+    Log.infoln("[IR] Learn mode started.");
+}
+
+void IrManager::cancelLearning()
+{
+    _learnState = IR_LEARN_IDLE;
+}
+
+IrLearnState IrManager::getLearnState() const
+{
+    return _learnState;
+}
+
+const IrLearnResult &IrManager::getLearnResult() const
+{
+    return _learnResult;
+}
+
+bool IrManager::takeLearnResult(IrLearnResult &result)
+{
+    if (_learnState != IR_LEARN_CAPTURED)
+    {
+        return false;
+    }
+    result = _learnResult;
+    _learnState = IR_LEARN_BOUND;
+    return true;
+}
+
+String IrManager::protocolName(int16_t protocol)
+{
+    return typeToString((decode_type_t)protocol);
+}
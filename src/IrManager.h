@@ -2,6 +2,61 @@
 #define IR_MANAGER_H
 
 #include <Arduino.h>
+#include <vector>
+#include "SettingsManager.h" // For DeviceSettings
+
+#define IR_QUEUE_SIZE 8       // Decoded events waiting for the main loop
+#define IR_RELEASE_MS 200     // Key counts as held while frames keep arriving within this window
+#define IR_RESEND_GAP_MS 130  // A full code resent sooner than this is a held key (RC5 resends every 114 ms)
+
+enum IrEventType : uint8_t
+{
+    IR_EVENT_PRESS,   // First frame of a key press
+    IR_EVENT_REPEAT,  // Key still held: a repeat frame, or the same code resent within IR_RESEND_GAP_MS
+    IR_EVENT_RELEASE  // No frame for IR_RELEASE_MS after a press
+};
+
+struct IrEvent
+{
+    uint64_t code;
+    uint32_t timestamp; // millis() when decoded
+    uint32_t holdMs;    // Time since the press for REPEAT and RELEASE events
+    IrEventType type;
+};
+
+enum IrActionType : uint8_t
+{
+    IR_ACTION_BRIGHTNESS_UP,
+    IR_ACTION_BRIGHTNESS_DOWN,
+    IR_ACTION_TOGGLE_CHANNEL,
+    IR_ACTION_RECALL_SCENE
+};
+
+// One code may appear several times to trigger multiple actions (e.g. a channel group)
+struct IrBinding
+{
+    uint64_t code;
+    IrActionType action;
+    uint8_t channel; // Index into DeviceSettings::channels, or ::scenes for scene actions
+};
+
+enum IrLearnState : uint8_t
+{
+    IR_LEARN_IDLE,
+    IR_LEARN_LISTENING, // Waiting for the next key press
+    IR_LEARN_CAPTURED,  // A code was captured, waiting to be bound
+    IR_LEARN_BOUND,     // The captured code was handed over and bound to its action
+    IR_LEARN_TIMEOUT
+};
+
+struct IrLearnResult
+{
+    uint64_t code;
+    int16_t protocol; // decode_type_t from IRremoteESP8266
+    uint16_t bits;
+    IrActionType action;
+    uint8_t channel;
+};
 
 class IrManager {
 public:
@@ -10,13 +65,57 @@ public:
     void loop();
     bool available();
     uint64_t read();
+    bool read(IrEvent &event);
     void resume();
+    uint32_t getDroppedEvents() const;
+
+    /**
+     * @brief Compiles the IR codes in the settings into a sorted binding table.
+     * Call whenever settings change so dispatch stays a single lookup.
+     */
+    void updateBindings(const DeviceSettings &settings);
+
+    /**
+     * @brief Finds all bindings for a code without allocating.
+     * @return Number of bindings; 'first' points at the first one.
+     */
+    size_t lookup(uint64_t code, const IrBinding *&first) const;
+
+    /**
+     * @brief Starts learn mode: the next key press is captured for the given
+     * action instead of being dispatched.
+     */
+    void startLearning(IrActionType action, uint8_t channel, uint32_t timeoutMs);
+    void cancelLearning();
+    IrLearnState getLearnState() const;
+    const IrLearnResult &getLearnResult() const;
+
+    /**
+     * @brief Hands over a freshly captured code once, moving learn mode to BOUND.
+     */
+    bool takeLearnResult(IrLearnResult &result);
+
+    static String protocolName(int16_t protocol);
+
+    // Formats a code as uppercase hex into a buffer of at least 17 bytes
+    static void formatCode(uint64_t code, char *buffer);
 
 private:
     uint8_t _irPin;
-    volatile bool _irAvailable;
-    volatile uint64_t _irData;
-    static void IRAM_ATTR irISR();
+    IrEvent _queue[IR_QUEUE_SIZE];
+    uint8_t _queueHead;
+    uint8_t _queueTail;
+    uint32_t _droppedEvents;
+    uint64_t _lastCode;
+    uint32_t _lastCodeTime;
+    uint32_t _pressStart;
+    bool _holding;
+    std::vector<IrBinding> _bindings;
+    IrLearnState _learnState;
+    IrLearnResult _learnResult;
+    uint32_t _learnDeadline;
+    void push(IrEventType type, uint64_t code, uint32_t timestamp);
+    void addBinding(uint64_t code, IrActionType action, uint8_t channel);
 };
 
 #endif // IR_MANAGER_H
@@ -0,0 +1,44 @@
+#ifndef LED_BACKEND_H
+#define LED_BACKEND_H
+
+#include <stdint.h>
+
+#define LED_DUTY_MAX 4095 // Duty range every backend accepts (12 bit)
+#define LED_PWM_FREQ 256  // Hz until settings choose another frequency
+
+/**
+ * Hardware behind a group of LED outputs. LedController owns brightness,
+ * inversion and fades and hands each backend plain duty cycles
+ * (0..LED_DUTY_MAX) for its own output numbers. Backends may batch writes
+ * until flush(), which the controller calls once per update.
+ */
+class LedBackend
+{
+public:
+    virtual ~LedBackend() {}
+
+    /**
+     * @brief Sets the hardware up. @return false if it is missing or failed.
+     */
+    virtual bool begin() = 0;
+
+    /**
+     * @brief Stops driving the outputs, e.g. before another backend takes them over.
+     * @param offDuty Duty that turns an LED off (0, or LED_DUTY_MAX for active-low
+     * wiring); every output is left at that level.
+     */
+    virtual void end(uint16_t offDuty) { (void)offDuty; }
+
+    /**
+     * @brief Sets the PWM frequency (clamped to what the hardware does) and whether
+     * outputs start their periods at evenly spread phases instead of together.
+     * @return true if the timing changed and outputs must be written again.
+     */
+    virtual bool setTiming(uint16_t frequencyHz, bool staggered) = 0;
+
+    virtual void write(uint8_t output, uint16_t duty) = 0;
+    virtual void flush() {}
+    virtual const char *name() const = 0;
+};
+
+#endif // LED_BACKEND_H
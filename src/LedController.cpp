@@ -1,14 +1,69 @@
 #include "LedController.h"
 #include <ArduinoLog.h>
+#include "LogToken.h"
+#include "Profiler.h"
 
-LedController::LedController(bool inverted) : _invertingLogic(inverted) {}
+LedController::LedController(bool inverted) : _invertingLogic(inverted)
+{
+    for (int i = 0; i < MAX_OUTPUTS; i++)
+    {
+        _currentDuty[i] = -1;
+        _startDuty[i] = -1;
+        _targetDuty[i] = -1;
+    }
+}
 
 void LedController::begin()
 {
     // Initialization of pins is now handled dynamically in update()
     // to support changing pin configurations.
-    analogWriteFreq(PWM_FREQ);   // Set to 256Hz, tells how many pwm cycles per second
-    analogWriteRange(PWM_RANGE); // tells the range of values for pwm, 0-100 here, ie each cycle is devided into 100 steps
+    _gpioBackend->begin();
+}
+
+void LedController::configure(const DeviceSettings &settings)
+{
+    LedBackend *gpioBackend = settings.pwmBackend == "soft" ? (LedBackend *)&_softPwm : &_gpio;
+    bool rewrite = gpioBackend->setTiming(settings.pwmFrequency, settings.pwmStagger);
+    if (gpioBackend != _gpioBackend)
+    {
+        // toDuty() of level 0 is the GPIOs' off duty, HIGH when they are active-low
+        _gpioBackend->end(toDuty(0, 0, 100));
+        _gpioBackend = gpioBackend;
+        _gpioBackend->begin();
+        rewrite = true;
+        Log.infoln("[LedCtrl] GPIO outputs now use %s.", _gpioBackend->name());
+    }
+    if (rewrite)
+    {
+        for (int output = 0; output < MAX_GPIO; output++)
+        {
+            _currentDuty[output] = -1;
+        }
+    }
+
+    uint8_t address = settings.pca9685Address;
+    if (_expander && _expander->getAddress() == address)
+    {
+        _expander->setTiming(settings.pwmFrequency, settings.pwmStagger);
+        return;
+    }
+    if (_expander)
+    {
+        _expander->end(toDuty(LED_OUTPUT_EXPANDER, 0, 100));
+        delete _expander;
+        _expander = nullptr;
+    }
+    // Expander outputs start over; the next update() writes them all
+    for (int output = LED_OUTPUT_EXPANDER; output < MAX_OUTPUTS; output++)
+    {
+        _currentDuty[output] = -1;
+    }
+    if (address != 0)
+    {
+        _expander = new Pca9685Backend(address);
+        _expander->setTiming(settings.pwmFrequency, settings.pwmStagger);
+        _expander->begin();
+    }
 }
 
 int LedController::pinNameToNumber(const String &pinName)
@@ -31,66 +86,155 @@ int LedController::pinNameToNumber(const String &pinName)
         return D7;
     if (pinName == "D8")
         return D8;
-    // Add other pin mappings as needed
+    // Expander channels "P0".."P15"
+    if (pinName.length() >= 2 && pinName.length() <= 3 && pinName[0] == 'P' && isDigit(pinName[1]))
+    {
+        int channel = pinName.substring(1).toInt();
+        if (channel < PCA9685_CHANNELS && String(channel) == pinName.substring(1))
+            return LED_OUTPUT_EXPANDER + channel;
+    }
     return -1; // Invalid pin name
 }
 
-void LedController::update(const DeviceSettings &settings)
+int LedController::toDuty(int output, int level, int levelMax) const
+{
+    // For active-low GPIOs full brightness is duty 0
+    bool inverted = _invertingLogic && output < MAX_GPIO;
+    return inverted ? map(level, 0, levelMax, PWM_RANGE, 0) : map(level, 0, levelMax, 0, PWM_RANGE);
+}
+
+void LedController::update(const DeviceSettings &settings, uint16_t transitionMs)
 {
-    Log.infoln("[LedCtrl] --- Update Function Start ---");
+    PROFILE_ZONE("led.update");
+    if (_live)
+    {
+        // Live input owns the outputs; re-map its frame in case pins or backends changed
+        applyLevels(settings, _liveLevels, _liveCount);
+        return;
+    }
+    LOGT_VERBOSE("[LedCtrl] --- Update Function Start ---");
 
     for (const auto &channel : settings.channels)
     {
-        Log.info("[LedCtrl] Processing channel for pin name: %s\n", channel.pin.c_str());
+        LOGT_VERBOSE("[LedCtrl] Processing channel for pin name: %s", channel.pin.c_str());
 
         int pin = pinNameToNumber(channel.pin);
         if (pin == -1)
         {
-            Log.info("[LedCtrl] ERROR: Invalid pin name: %s\n", channel.pin.c_str());
+            LOGT_WARNING("[LedCtrl] Invalid pin name: %s", channel.pin.c_str());
             continue; // Skip to the next channel
         }
-        Log.info("[LedCtrl] Pin number: %d\n", pin);
-
-        // Initialize pin mode if not already done.
-        pinMode(pin, OUTPUT);
+        LOGT_VERBOSE("[LedCtrl] Pin number: %d", pin);
 
         int brightness = channel.schedulerActive ? channel.scheduledBrightness : channel.brightness;
         bool state = channel.schedulerActive ? true : channel.state;
 
-        Log.info("[LedCtrl] Raw settings - State: %s, Brightness: %d\n", state ? "ON" : "OFF", brightness);
+        LOGT_VERBOSE("[LedCtrl] Raw settings - State: %s, Brightness: %d", state ? "ON" : "OFF", brightness);
 
         // Constrain brightness to 0-100 range
         int clampedBrightness = constrain(brightness, 0, 100);
-        Log.info("[LedCtrl] Constrained Brightness: %d\n", clampedBrightness);
-
-        if (state)
-        { // If the channel should be ON
-            Log.infoln("[LedCtrl] Channel is ON");
-            int dutyCycle;
-            if (_invertingLogic)
-            {
-                // For active-low, 100% brightness is PWM 0, and 0% is PWM 255.
-                dutyCycle = map(clampedBrightness, 0, 100, PWM_RANGE, 0);
-                Log.info("[LedCtrl] Inverting logic ON. Writing analog value: %d\n", dutyCycle);
-                analogWrite(pin, dutyCycle);
-            }
-            else
-            {
-                // For active-high, 100% brightness is PWM 255.
-                dutyCycle = map(clampedBrightness, 0, 100, 0, PWM_RANGE);
-                Log.info("[LedCtrl] Inverting logic OFF. Writing analog value: %d\n", dutyCycle);
-                analogWrite(pin, dutyCycle);
-            }
-        }
-        else
-        { // If the channel should be OFF
-            Log.infoln("[LedCtrl] Channel is OFF");
-            // Set pin to the OFF state
-            int offState = _invertingLogic ? PWM_RANGE : 0;
-            Log.info("[LedCtrl] Writing digital value: %s\n", offState == HIGH ? "HIGH" : "LOW");
-            analogWrite(pin, offState);
+        LOGT_VERBOSE("[LedCtrl] Constrained Brightness: %d", clampedBrightness);
+
+        // An OFF channel is brightness 0, whichever way the output is wired
+        _targetDuty[pin] = toDuty(pin, state ? clampedBrightness : 0, 100);
+        LOGT_VERBOSE("[LedCtrl] Channel is %s. Target duty: %d", state ? "ON" : "OFF", _targetDuty[pin]);
+
+        if (transitionMs == 0 || _currentDuty[pin] < 0)
+        {
+            writeDuty(pin, _targetDuty[pin]);
         }
-        Log.infoln("[LedCtrl] --- Channel Processing End ---");
+        _startDuty[pin] = _currentDuty[pin];
+        LOGT_VERBOSE("[LedCtrl] --- Channel Processing End ---");
     }
-    Log.infoln("[LedCtrl] --- Update Function End ---");
+    flush();
+    _transitionActive = transitionMs > 0;
+    _transitionStart = millis();
+    _transitionMs = transitionMs;
+    LOGT_VERBOSE("[LedCtrl] --- Update Function End ---");
+}
+
+void LedController::loop()
+{
+    if (!_transitionActive)
+        return;
+
+    unsigned long elapsed = millis() - _transitionStart;
+    bool done = elapsed >= _transitionMs;
+    for (int output = 0; output < MAX_OUTPUTS; output++)
+    {
+        if (_targetDuty[output] < 0 || _currentDuty[output] == _targetDuty[output])
+            continue;
+        int duty = done ? _targetDuty[output] : _startDuty[output] + (long)(_targetDuty[output] - _startDuty[output]) * (long)elapsed / _transitionMs;
+        writeDuty(output, duty);
+    }
+    flush();
+    _transitionActive = !done;
+}
+
+void LedController::restore(const int16_t *duty)
+{
+    for (int pin = 0; pin < MAX_GPIO; pin++)
+    {
+        if (duty[pin] < 0)
+            continue;
+        _targetDuty[pin] = duty[pin];
+        writeDuty(pin, duty[pin]);
+    }
+    _transitionActive = false;
+}
+
+void LedController::applyLevels(const DeviceSettings &settings, const uint8_t *levels, size_t count)
+{
+    PROFILE_ZONE("led.levels");
+    count = min(count, (size_t)MAX_OUTPUTS);
+    if (levels != _liveLevels)
+        memcpy(_liveLevels, levels, count);
+    _liveCount = count;
+    _live = true;
+    for (size_t i = 0; i < count && i < settings.channels.size(); i++)
+    {
+        int pin = pinNameToNumber(settings.channels[i].pin);
+        if (pin == -1)
+            continue;
+        _targetDuty[pin] = toDuty(pin, levels[i], 255);
+        writeDuty(pin, _targetDuty[pin]);
+    }
+    flush();
+    _transitionActive = false;
+}
+
+void LedController::releaseLevels()
+{
+    _live = false;
+}
+
+int16_t LedController::getTargetDuty(int pin) const
+{
+    return pin >= 0 && pin < MAX_OUTPUTS ? _targetDuty[pin] : -1;
+}
+
+SoftPwmBackend *LedController::getSoftPwm()
+{
+    return _gpioBackend == &_softPwm ? &_softPwm : nullptr;
+}
+
+void LedController::writeDuty(int output, int dutyCycle)
+{
+    if (_currentDuty[output] == dutyCycle)
+        return;
+    if (output < MAX_GPIO)
+        _gpioBackend->write(output, dutyCycle);
+    else if (_expander)
+        _expander->write(output - LED_OUTPUT_EXPANDER, dutyCycle);
+    else
+        return; // Stays unwritten until an expander is configured
+    _currentDuty[output] = dutyCycle;
+}
+
+void LedController::flush()
+{
+    // Software PWM rebuilds its edge table; the expander sends one I2C burst. Both only if something changed.
+    _gpioBackend->flush();
+    if (_expander)
+        _expander->flush();
 }
\ No newline at end of file
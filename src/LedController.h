@@ -3,6 +3,12 @@
 
 #include <Arduino.h>
 #include "SettingsManager.h" // For DeviceSettings
+#include "LedBackend.h"
+#include "GpioPwmBackend.h"
+#include "SoftPwmBackend.h"
+#include "Pca9685Backend.h"
+
+#define LED_OUTPUT_EXPANDER 17 // Output number of PCA9685 channel P0; GPIOs use their own numbers
 
 class LedController
 {
@@ -20,18 +26,80 @@ public:
      */
     void begin();
 
+    /**
+     * @brief Sets up output hardware from the settings (GPIO PWM engine, PCA9685 expander). Call after
+     * settings load and whenever they change; follow with update().
+     */
+    void configure(const DeviceSettings &settings);
+
     /**
      * @brief Updates all LED channels based on the provided settings.
      * @param settings The device settings containing all channel configurations.
+     * @param transitionMs Fade from the current output to the new one over this time, 0 applies immediately.
+     */
+    void update(const DeviceSettings &settings, uint16_t transitionMs = 0);
+
+    /**
+     * @brief Advances a running transition. Call from the main loop.
+     */
+    void loop();
+
+    /**
+     * @brief Drives raw duty values (0..PWM_RANGE) right away, e.g. the last known output at boot.
+     * @param duty One entry per GPIO (MAX_GPIO), negative entries are left alone.
+     */
+    void restore(const int16_t *duty);
+
+    /**
+     * @brief Drives channels from 8-bit live levels (DMX), cancelling any transition. Settings are not touched.
+     * @param levels One level per channel in settings order, 0-255.
+     * @param count Number of entries in levels.
      */
-    void update(const DeviceSettings &settings);
+    void applyLevels(const DeviceSettings &settings, const uint8_t *levels, size_t count);
+
+    /**
+     * @brief Ends live levels so update() drives the stored state again. Until then update() re-applies the
+     * last live levels, so settings changes made meanwhile don't override them.
+     */
+    void releaseLevels();
+
+    /**
+     * @brief Duty a GPIO is at or fading towards, -1 if it was never driven.
+     */
+    int16_t getTargetDuty(int pin) const;
+
+    /**
+     * @brief The software PWM engine while it drives the GPIOs, else nullptr.
+     */
+    SoftPwmBackend *getSoftPwm();
+
+    /**
+     * @brief Maps "D0".."D8" to GPIO numbers and "P0".."P15" to expander outputs, -1 if unknown.
+     */
+    static int pinNameToNumber(const String &pinName);
+
+    static const int MAX_GPIO = 17;                                     // GPIO0..GPIO16
+    static const int MAX_OUTPUTS = LED_OUTPUT_EXPANDER + PCA9685_CHANNELS; // GPIOs, then expander channels
+    static const int PWM_RANGE = LED_DUTY_MAX;                          // 12 bit on every backend
 
 private:
-    bool _invertingLogic;
-    // The ESP8266 has a 10-bit PWM resolution, so the range is 0-255.
-    const int PWM_RANGE = 100;
-    const int PWM_FREQ = 256; // Set PWM frequency to 256Hz
-    int pinNameToNumber(const String &pinName);
+    bool _invertingLogic; // Applies to GPIOs; expander outputs drive MOSFETs and are active-high
+    int16_t _currentDuty[MAX_OUTPUTS]; // Last duty written per output, -1 if never written
+    int16_t _startDuty[MAX_OUTPUTS];
+    int16_t _targetDuty[MAX_OUTPUTS];
+    unsigned long _transitionStart = 0;
+    uint16_t _transitionMs = 0;
+    bool _transitionActive = false;
+    uint8_t _liveLevels[MAX_OUTPUTS]; // Last applyLevels() frame, held until releaseLevels()
+    size_t _liveCount = 0;
+    bool _live = false;
+    GpioPwmBackend _gpio;
+    SoftPwmBackend _softPwm;
+    LedBackend *_gpioBackend = &_gpio; // analogWrite or software PWM, both need timer1
+    Pca9685Backend *_expander = nullptr;
+    void writeDuty(int output, int dutyCycle);
+    void flush();
+    int toDuty(int output, int level, int levelMax) const;
 };
 
 #endif // LED_CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,25 @@
+#include "LogToken.h"
+
+TokenLogger LogT;
+
+void TokenLogger::begin(Print *output)
+{
+    _output = output;
+}
+
+void TokenLogger::put(uint8_t *buffer, size_t &length, const char *value)
+{
+    if (value == nullptr)
+        value = "";
+    size_t room = LOG_RECORD_MAX + 2 - length;
+    if (room == 0)
+        return;
+    size_t count = strlen(value);
+    if (count > room - 1)
+        count = room - 1;
+    if (count > 255)
+        count = 255;
+    buffer[length++] = (uint8_t)count;
+    memcpy(&buffer[length], value, count);
+    length += count;
+}
@@ -0,0 +1,118 @@
+#ifndef LOG_TOKEN_H
+#define LOG_TOKEN_H
+
+#include <Arduino.h>
+#include <ArduinoLog.h>
+#include <type_traits>
+
+// Binary record layout: MARKER, length, level, id (4 bytes LE), args...
+// where length counts the bytes after itself. Integers and bools are sent as
+// 4 byte little-endian values, floats as IEEE754 singles, strings as a length
+// byte followed by the characters. tools/logtokens.py and the web UI decode
+// records using data/logtokens.json, generated from the LOGT_* call sites.
+#define LOG_RECORD_MARKER 0x1E
+#define LOG_RECORD_MAX 255
+#define LOG_RECORD_HEADER 7 // marker + length + level + id
+
+namespace LogToken
+{
+    // FNV-1a over the format string, evaluated at compile time for each call site
+    constexpr uint32_t hash(const char *s, uint32_t h = 2166136261u)
+    {
+        return *s ? hash(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+    }
+}
+
+/**
+ * Deferred-formatting logger. Writes only the call site's token id and raw
+ * arguments to the log sink; formatting happens on the host or in the browser.
+ */
+class TokenLogger
+{
+public:
+    void begin(Print *output);
+
+    template <typename... Args>
+    void record(int level, uint32_t id, Args... args)
+    {
+        if (_output == nullptr || level > Log.getLevel())
+            return;
+        uint8_t buffer[LOG_RECORD_MAX + 2];
+        size_t length = LOG_RECORD_HEADER;
+        buffer[0] = LOG_RECORD_MARKER;
+        buffer[2] = (uint8_t)level;
+        putU32(&buffer[3], id);
+        append(buffer, length, args...);
+        buffer[1] = (uint8_t)(length - 2);
+        _output->write(buffer, length);
+    }
+
+private:
+    Print *_output = nullptr;
+
+    static void putU32(uint8_t *dst, uint32_t value)
+    {
+        dst[0] = value;
+        dst[1] = value >> 8;
+        dst[2] = value >> 16;
+        dst[3] = value >> 24;
+    }
+
+    static void append(uint8_t *, size_t &) {}
+
+    template <typename T, typename... Rest>
+    static void append(uint8_t *buffer, size_t &length, T value, Rest... rest)
+    {
+        put(buffer, length, value);
+        append(buffer, length, rest...);
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+    put(uint8_t *buffer, size_t &length, T value)
+    {
+        if (length + 4 > LOG_RECORD_MAX + 2)
+            return;
+        putU32(&buffer[length], (uint32_t)value);
+        length += 4;
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type
+    put(uint8_t *buffer, size_t &length, T value)
+    {
+        if (length + 4 > LOG_RECORD_MAX + 2)
+            return;
+        float f = value;
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        putU32(&buffer[length], bits);
+        length += 4;
+    }
+
+    static void put(uint8_t *buffer, size_t &length, const char *value);
+    static void put(uint8_t *buffer, size_t &length, const String &value) { put(buffer, length, value.c_str()); }
+};
+
+extern TokenLogger LogT;
+
+// Hot-path log macros. With -DLOG_TOKENIZED only the token id and raw
+// arguments are emitted; otherwise they fall back to regular ArduinoLog lines
+// with the format string kept in flash. Each call ends the line.
+#ifdef LOG_TOKENIZED
+#define LOGT_RECORD(level, fmt, ...) \
+    LogT.record(level, std::integral_constant<uint32_t, LogToken::hash(fmt)>::value, ##__VA_ARGS__)
+#define LOGT_ERROR(fmt, ...) LOGT_RECORD(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOGT_WARNING(fmt, ...) LOGT_RECORD(LOG_LEVEL_WARNING, fmt, ##__VA_ARGS__)
+#define LOGT_INFO(fmt, ...) LOGT_RECORD(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOGT_TRACE(fmt, ...) LOGT_RECORD(LOG_LEVEL_TRACE, fmt, ##__VA_ARGS__)
+#define LOGT_VERBOSE(fmt, ...) LOGT_RECORD(LOG_LEVEL_VERBOSE, fmt, ##__VA_ARGS__)
+#else
+#define LOGT_ERROR(fmt, ...) Log.errorln(F(fmt), ##__VA_ARGS__)
+#define LOGT_WARNING(fmt, ...) Log.warningln(F(fmt), ##__VA_ARGS__)
+#define LOGT_INFO(fmt, ...) Log.infoln(F(fmt), ##__VA_ARGS__)
+#define LOGT_TRACE(fmt, ...) Log.traceln(F(fmt), ##__VA_ARGS__)
+#define LOGT_VERBOSE(fmt, ...) Log.verboseln(F(fmt), ##__VA_ARGS__)
+#endif
+
+#endif // LOG_TOKEN_H
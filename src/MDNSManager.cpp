@@ -6,13 +6,16 @@ MDNSManager::MDNSManager() {}
 void MDNSManager::begin(const char *hostname)
 {
     _hostname = hostname;
+    MDNS.setHostProbeResultCallback([this](const char *domainName, bool probeResult)
+                                    { handleProbeResult(domainName, probeResult); });
     if (!MDNS.begin(_hostname))
     {
         Log.infoln("[mDNS] Error setting up MDNS responder!");
     }
     else
     {
-        Log.info("[mDNS] MDNS responder started with hostname: %s.local\n", _hostname);
+        _started = true;
+        Log.info("[mDNS] MDNS responder started with hostname: %s.local\n", _hostname.c_str());
         // Add service for web server (HTTP on TCP port 80)
         MDNS.addService("http", "tcp", 80);
         Log.infoln("[mDNS] HTTP service registered.");
@@ -21,5 +24,79 @@ void MDNSManager::begin(const char *hostname)
 
 void MDNSManager::loop()
 {
-    MDNS.update(); // Keep the mDNS responder active
-}
\ No newline at end of file
+    MDNS.update(); // Keep the mDNS responder active, also drives host probing
+}
+
+bool MDNSManager::rename(const String &hostname)
+{
+    if (!_started)
+    {
+        Log.infoln("[mDNS] Rename ignored, responder not running.");
+        return false;
+    }
+    if (hostname == _hostname || hostname == _pendingHostname)
+    {
+        return true; // Nothing to do or already probing this name
+    }
+    if (isProbing())
+    {
+        Log.infoln("[mDNS] Rename to %s rejected, still probing %s.", hostname.c_str(), _pendingHostname.c_str());
+        return false;
+    }
+
+    Log.infoln("[mDNS] Probing new hostname: %s.local", hostname.c_str());
+    _pendingHostname = hostname;
+    // setHostname() restarts probing and announcing; the outcome arrives in handleProbeResult()
+    if (!MDNS.setHostname(_pendingHostname.c_str()))
+    {
+        Log.infoln("[mDNS] Hostname %s rejected by responder.", hostname.c_str());
+        _pendingHostname = "";
+        return false;
+    }
+    return true;
+}
+
+void MDNSManager::handleProbeResult(const char *domainName, bool probeResult)
+{
+    if (!isProbing())
+    {
+        if (!probeResult)
+        {
+            Log.warningln("[mDNS] Hostname %s.local is in use on the network.", domainName);
+        }
+        return; // Probe of the boot-time name, nothing pending
+    }
+
+    String requested = _pendingHostname;
+    _pendingHostname = "";
+    if (probeResult)
+    {
+        _hostname = requested;
+        Log.infoln("[mDNS] Renamed to %s.local", _hostname.c_str());
+    }
+    else
+    {
+        Log.infoln("[mDNS] Hostname %s.local already in use. Keeping %s.local", requested.c_str(), _hostname.c_str());
+        MDNS.setHostname(_hostname.c_str());
+    }
+
+    if (_renameCallback)
+    {
+        _renameCallback(requested, probeResult);
+    }
+}
+
+bool MDNSManager::isProbing() const
+{
+    return _pendingHostname.length() > 0;
+}
+
+const String &MDNSManager::getHostname() const
+{
+    return _hostname;
+}
+
+void MDNSManager::onRename(RenameCallback callback)
+{
+    _renameCallback = callback;
+}
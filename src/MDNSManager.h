@@ -3,16 +3,35 @@
 
 #include <ESP8266mDNS.h>
 #include <Arduino.h> // For Log.infoln
+#include <functional>
 
 class MDNSManager
 {
 public:
+    // Called once probing for a requested hostname finishes: success == false means the name was taken
+    typedef std::function<void(const String &hostname, bool success)> RenameCallback;
+
     MDNSManager();
     void begin(const char *hostname);
     void loop(); // New method to be called in main loop
 
+    /**
+     * @brief Re-announces the responder under a new hostname without restarting.
+     * Conflict probing runs asynchronously inside loop(); the result is reported
+     * through the rename callback and the previous name is restored on conflict.
+     * @return false if the responder is not running or the name was rejected.
+     */
+    bool rename(const String &hostname);
+    bool isProbing() const;
+    const String &getHostname() const;
+    void onRename(RenameCallback callback);
+
 private:
-    const char *_hostname;
+    String _hostname;
+    String _pendingHostname;
+    bool _started = false;
+    RenameCallback _renameCallback;
+    void handleProbeResult(const char *domainName, bool probeResult);
 };
 
-#endif
\ No newline at end of file
+#endif
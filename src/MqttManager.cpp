@@ -0,0 +1,168 @@
+#include "MqttManager.h"
+#include <ArduinoLog.h>
+
+MqttManager::MqttManager(CommandQueue &queue, SettingsManager &settingsMgr)
+    : _client(_wifiClient), _queue(queue), _settingsManager(settingsMgr), _port(0), _nextAttempt(0), _retryDelay(MQTT_RETRY_MIN_MS)
+{
+}
+
+void MqttManager::loop()
+{
+    const DeviceSettings &settings = _settingsManager.getSettings();
+    if (configChanged(settings))
+    {
+        if (_client.connected())
+        {
+            _client.publish((_topic + "/status").c_str(), "offline", true);
+            _client.disconnect();
+        }
+        _host = settings.mqttHost;
+        _port = settings.mqttPort;
+        _user = settings.mqttUser;
+        _password = settings.mqttPassword;
+        _topic = settings.mqttTopic.length() ? settings.mqttTopic : "ledbar/" + settings.mDNSName;
+        _nextAttempt = millis();
+        _retryDelay = MQTT_RETRY_MIN_MS;
+    }
+    if (_host.length() == 0 || WiFi.status() != WL_CONNECTED)
+        return;
+
+    if (!_client.connected())
+    {
+        if ((long)(millis() - _nextAttempt) >= 0)
+            connect(settings);
+        return;
+    }
+    _client.loop();
+    publishChanges(settings);
+}
+
+bool MqttManager::isConnected()
+{
+    return _client.connected();
+}
+
+bool MqttManager::configChanged(const DeviceSettings &settings)
+{
+    String topic = settings.mqttTopic.length() ? settings.mqttTopic : "ledbar/" + settings.mDNSName;
+    return settings.mqttHost != _host || settings.mqttPort != _port || settings.mqttUser != _user ||
+           settings.mqttPassword != _password || topic != _topic;
+}
+
+void MqttManager::connect(const DeviceSettings &settings)
+{
+    String clientId = "ledbar-" + String(ESP.getChipId(), HEX);
+    String statusTopic = _topic + "/status";
+    // PubSubClient would resolve a name without a timeout of its own, so look it up here
+    IPAddress address;
+    bool resolved = address.fromString(_host) || WiFi.hostByName(_host.c_str(), address, MQTT_DNS_TIMEOUT_MS);
+    _client.setServer(address, _port);
+    _client.setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+    _wifiClient.setTimeout(MQTT_CONNECT_TIMEOUT_MS); // Bounds the TCP connect
+    _client.setCallback([this](char *topic, uint8_t *payload, unsigned int length)
+                        { handleMessage(topic, payload, length); });
+
+    bool connected = resolved &&
+                     (_user.length()
+                          ? _client.connect(clientId.c_str(), _user.c_str(), _password.c_str(), statusTopic.c_str(), 1, true, "offline")
+                          : _client.connect(clientId.c_str(), statusTopic.c_str(), 1, true, "offline"));
+    if (!connected)
+    {
+        Log.warningln("[MQTT] Connect to %s:%d failed (%s). Retrying in %u s.", _host.c_str(), _port,
+                      resolved ? "no answer" : "name not resolved", (unsigned long)(_retryDelay / 1000));
+        _nextAttempt = millis() + _retryDelay;
+        _retryDelay = min(_retryDelay * 2, (unsigned long)MQTT_RETRY_MAX_MS);
+        return;
+    }
+
+    Log.infoln("[MQTT] Connected to %s:%d as %s.", _host.c_str(), _port, _topic.c_str());
+    _retryDelay = MQTT_RETRY_MIN_MS;
+    _client.publish(statusTopic.c_str(), "online", true);
+    _client.subscribe((_topic + "/channel/+/set").c_str());
+    _client.subscribe((_topic + "/channel/+/brightness/set").c_str());
+    // Retained state may be stale or missing after our absence; republish everything
+    _published.clear();
+    publishChanges(settings);
+}
+
+void MqttManager::publishChanges(const DeviceSettings &settings)
+{
+    if (_published.size() != settings.channels.size())
+    {
+        // Channel layout changed: force a full publish with impossible values
+        _published.assign(settings.channels.size(), Published{false, -1});
+    }
+    char topic[96];
+    char value[8];
+    for (size_t i = 0; i < settings.channels.size(); i++)
+    {
+        const ChannelSetting &channel = settings.channels[i];
+        Published &published = _published[i];
+        if (published.brightness < 0 || published.state != channel.state)
+        {
+            snprintf(topic, sizeof(topic), "%s/channel/%u/state", _topic.c_str(), (unsigned)i);
+            if (!_client.publish(topic, channel.state ? "ON" : "OFF", true))
+                return; // Retry on the next pass
+        }
+        if (published.brightness != channel.brightness)
+        {
+            snprintf(topic, sizeof(topic), "%s/channel/%u/brightness", _topic.c_str(), (unsigned)i);
+            snprintf(value, sizeof(value), "%d", channel.brightness);
+            if (!_client.publish(topic, value, true))
+                return;
+        }
+        published.state = channel.state;
+        published.brightness = channel.brightness;
+    }
+}
+
+void MqttManager::handleMessage(char *topic, uint8_t *payload, unsigned int length)
+{
+    // <topic>/channel/<n>/set or <topic>/channel/<n>/brightness/set
+    String prefix = _topic + "/channel/";
+    if (strncmp(topic, prefix.c_str(), prefix.length()) != 0)
+        return;
+    char *end;
+    unsigned long channel = strtoul(topic + prefix.length(), &end, 10);
+    if (end == topic + prefix.length() || channel >= _settingsManager.getSettings().channels.size())
+        return;
+
+    char message[16];
+    size_t messageLength = min((size_t)length, sizeof(message) - 1);
+    memcpy(message, payload, messageLength);
+    message[messageLength] = '\0';
+
+    Command command;
+    command.channel = channel;
+    command.persist = true;
+    if (strcmp(end, "/set") == 0)
+    {
+        if (strcasecmp(message, "TOGGLE") == 0)
+        {
+            command.type = CMD_TOGGLE_CHANNEL;
+        }
+        else if (strcasecmp(message, "ON") == 0 || strcasecmp(message, "OFF") == 0)
+        {
+            command.type = CMD_SET_CHANNEL;
+            command.state = strcasecmp(message, "ON") == 0;
+        }
+        else
+        {
+            Log.warningln("[MQTT] Unknown payload %s on %s.", message, topic);
+            return;
+        }
+    }
+    else if (strcmp(end, "/brightness/set") == 0)
+    {
+        // Setting a brightness turns the channel on, 0 turns it off
+        int brightness = constrain(atoi(message), 0, 100);
+        command.type = CMD_SET_CHANNEL;
+        command.state = brightness > 0;
+        command.value = brightness > 0 ? brightness : -1;
+    }
+    else
+    {
+        return;
+    }
+    _queue.push(command);
+}
@@ -0,0 +1,71 @@
+#ifndef MQTT_MANAGER_H
+#define MQTT_MANAGER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <PubSubClient.h>
+#include <vector>
+#include "CommandQueue.h"
+#include "SettingsManager.h"
+
+#define MQTT_RETRY_MIN_MS 5000      // First reconnect delay, doubling up to MQTT_RETRY_MAX_MS
+#define MQTT_RETRY_MAX_MS 60000
+#define MQTT_DNS_TIMEOUT_MS 500     // Broker name lookup; skipped when the host is an IP address
+#define MQTT_CONNECT_TIMEOUT_MS 250 // TCP connect; a broker on the LAN answers within a few ms
+#define MQTT_SOCKET_TIMEOUT 1       // Seconds PubSubClient waits for CONNACK (its minimum)
+
+/**
+ * MQTT bridge with DeviceSettings as the source of truth. Per channel it
+ * publishes retained <topic>/channel/<n>/state (ON/OFF) and .../brightness
+ * whenever the settings differ from what was last published, and turns
+ * .../set (ON, OFF, TOGGLE) and .../brightness/set messages into commands.
+ * <topic>/status carries a retained online/offline (last will).
+ * Disabled while settings.mqttHost is empty.
+ *
+ * Connecting blocks the loop: PubSubClient has no asynchronous connect.
+ * An unreachable broker costs at most MQTT_DNS_TIMEOUT_MS +
+ * MQTT_CONNECT_TIMEOUT_MS (750 ms) per attempt, once every 5-60 s of
+ * backoff. A host that accepts the TCP connection but never answers MQTT
+ * adds up to MQTT_SOCKET_TIMEOUT.
+ */
+class MqttManager
+{
+public:
+    MqttManager(CommandQueue &queue, SettingsManager &settingsMgr);
+
+    /**
+     * @brief Follows settings changes, keeps the connection up and publishes changes.
+     */
+    void loop();
+    bool isConnected();
+
+private:
+    struct Published
+    {
+        bool state;
+        int brightness;
+    };
+
+    WiFiClient _wifiClient;
+    PubSubClient _client;
+    CommandQueue &_queue;
+    SettingsManager &_settingsManager;
+
+    // Configuration the current connection was made with
+    String _host;
+    uint16_t _port;
+    String _user;
+    String _password;
+    String _topic;
+
+    std::vector<Published> _published;
+    unsigned long _nextAttempt;
+    unsigned long _retryDelay;
+
+    bool configChanged(const DeviceSettings &settings);
+    void connect(const DeviceSettings &settings);
+    void publishChanges(const DeviceSettings &settings);
+    void handleMessage(char *topic, uint8_t *payload, unsigned int length);
+};
+
+#endif // MQTT_MANAGER_H
@@ -1,7 +1,9 @@
 #include "OTAUpdater.h"
 #include <ArduinoLog.h>
+#include <LittleFS.h>
+#include <flash_hal.h>
 
-OTAUpdater::OTAUpdater() {}
+OTAUpdater::OTAUpdater() : _inflater(nullptr), _uploadActive(false), _filesystem(false), _sniffed(false), _received(0), _restartAt(0) {}
 
 void OTAUpdater::begin(const char *hostname)
 {
@@ -13,8 +15,12 @@ void OTAUpdater::begin(const char *hostname)
     ArduinoOTA.onStart([]()
                        { Log.infoln("[OTA] Start updating"); });
 
-    ArduinoOTA.onEnd([]()
-                     { Log.infoln("\n[OTA] Update complete"); });
+    ArduinoOTA.onEnd([this]()
+                     {
+        Log.infoln("\n[OTA] Update complete");
+        // ArduinoOTA reboots right after this returns
+        if (ArduinoOTA.getCommand() == U_FLASH && _restartCallback)
+            _restartCallback(); });
 
     ArduinoOTA.onProgress([](unsigned int progress, unsigned int total)
                           { Log.info("[OTA] Progress: %u%%\r", (progress / (total / 100))); });
@@ -34,4 +40,143 @@ void OTAUpdater::begin(const char *hostname)
             Log.infoln("End Failed"); });
     ArduinoOTA.begin();
     Log.infoln("[OTA] Ready for updates");
-}
\ No newline at end of file
+}
+
+void OTAUpdater::loop()
+{
+    ArduinoOTA.handle();
+    if (_restartAt != 0 && (long)(millis() - _restartAt) >= 0)
+    {
+        Log.infoln("[OTA] Restarting into the new image.");
+        if (!_filesystem && _restartCallback)
+            _restartCallback();
+        ESP.restart();
+    }
+}
+
+void OTAUpdater::onRestart(RestartCallback callback)
+{
+    _restartCallback = callback;
+}
+
+bool OTAUpdater::beginUpload(bool filesystem, const String &md5)
+{
+    if (_uploadActive)
+        abortUpload();
+    _uploadError = "";
+    _filesystem = filesystem;
+    _sniffed = false;
+    _received = 0;
+
+    size_t space;
+    if (filesystem)
+    {
+        // The image replaces the whole filesystem; nothing may write to it meanwhile
+        space = (size_t)FS_end - (size_t)FS_start;
+        LittleFS.end();
+    }
+    else
+    {
+        space = (ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000;
+    }
+    if (!Update.begin(space, filesystem ? U_FS : U_FLASH))
+        return failUpload(Update.getErrorString());
+    if (md5.length() > 0 && !Update.setMD5(md5.c_str()))
+        return failUpload("invalid MD5");
+
+    _uploadActive = true;
+    Log.infoln("[OTA] HTTP %s upload started.", filesystem ? "filesystem" : "firmware");
+    return true;
+}
+
+bool OTAUpdater::writeUpload(const uint8_t *data, size_t length)
+{
+    if (!_uploadActive)
+        return false;
+    if (!_sniffed && length > 0)
+    {
+        // gzip magic selects the inflating path, anything else is flashed as is.
+        // Upload chunks are far larger than the three bytes looked at.
+        _sniffed = true;
+        if (GzipInflater::isGzip(data, length))
+        {
+            _inflater = new GzipInflater();
+            if (!_inflater->begin([this](const uint8_t *out, size_t outLength)
+                                  { return writeImage(out, outLength); }))
+                return failUpload(_inflater->getError());
+        }
+    }
+    _received += length;
+    if (_inflater)
+    {
+        if (!_inflater->write(data, length))
+            return failUpload(_uploadError.length() ? _uploadError : String("gzip: ") + _inflater->getError());
+        return true;
+    }
+    return writeImage(data, length);
+}
+
+bool OTAUpdater::writeImage(const uint8_t *data, size_t length)
+{
+    if (Update.write(const_cast<uint8_t *>(data), length) != length)
+    {
+        _uploadError = Update.getErrorString();
+        return false;
+    }
+    return true;
+}
+
+bool OTAUpdater::endUpload()
+{
+    if (!_uploadActive)
+        return false;
+    if (_inflater && !_inflater->end())
+        return failUpload(_uploadError.length() ? _uploadError : String("gzip: ") + _inflater->getError());
+    // Size comes from what was written; MD5 (if given) is checked here
+    if (!Update.end(true))
+        return failUpload(Update.getErrorString());
+
+    Log.infoln("[OTA] HTTP upload complete: %u bytes received, %u written.", (unsigned long)_received, (unsigned long)Update.progress());
+    delete _inflater;
+    _inflater = nullptr;
+    _uploadActive = false;
+    _restartAt = millis() + OTA_RESTART_DELAY;
+    return true;
+}
+
+void OTAUpdater::abortUpload()
+{
+    if (_uploadActive)
+        failUpload("upload aborted");
+}
+
+const String &OTAUpdater::getUploadError()
+{
+    return _uploadError;
+}
+
+bool OTAUpdater::failUpload(const String &error)
+{
+    _uploadError = error;
+    Log.errorln("[OTA] HTTP upload failed: %s", error.c_str());
+    if (Update.isRunning())
+        Update.end(false);
+    delete _inflater;
+    _inflater = nullptr;
+    _uploadActive = false;
+    if (_filesystem)
+    {
+        // Once Update has started erasing, nothing mountable is left. The core's
+        // default would format it and wipe settings, so mount without that and
+        // report the loss; an untouched partition mounts as before.
+        LittleFSConfig config;
+        config.setAutoFormat(false);
+        LittleFS.setConfig(config);
+        if (!LittleFS.begin())
+        {
+            _uploadError += "; filesystem erased, re-flash it";
+            Log.errorln("[OTA] Filesystem partition is partly erased and must be re-flashed.");
+        }
+    }
+    return false;
+}
@@ -3,15 +3,55 @@
 
 #include <Arduino.h>
 #include <ArduinoOTA.h>
+#include <functional>
+#include "GzipInflater.h"
+
+#define OTA_RESTART_DELAY 1000 // Let the HTTP response go out before rebooting into the new image
 
 class OTAUpdater
 {
 public:
+    // Called right before rebooting into new firmware, e.g. to save pending settings
+    typedef std::function<void()> RestartCallback;
+
     OTAUpdater();
     void begin(const char *hostname);
 
+    /**
+     * @brief Runs ArduinoOTA and the reboot after a successful HTTP upload. Call from the main loop.
+     */
+    void loop();
+
+    /**
+     * @brief Starts flashing an uploaded image. Gzip images are inflated on the fly, raw ones written as is.
+     * @param filesystem true for a LittleFS image, false for firmware.
+     * @param md5 Hex MD5 of the uncompressed image, empty to skip the check.
+     */
+    bool beginUpload(bool filesystem, const String &md5);
+    bool writeUpload(const uint8_t *data, size_t length);
+    bool endUpload();
+    void abortUpload();
+    const String &getUploadError();
+
+    /**
+     * @brief Sets the callback run before a reboot into new firmware. Not called
+     * after a filesystem image, which has already replaced the settings file.
+     */
+    void onRestart(RestartCallback callback);
+
 private:
     const char *_hostname;
+    GzipInflater *_inflater;
+    bool _uploadActive;
+    bool _filesystem;
+    bool _sniffed;
+    size_t _received;
+    String _uploadError;
+    unsigned long _restartAt;
+    RestartCallback _restartCallback;
+
+    bool writeImage(const uint8_t *data, size_t length);
+    bool failUpload(const String &error);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,140 @@
+#include "Pca9685Backend.h"
+#include <Wire.h>
+#include <ArduinoLog.h>
+
+#define PCA9685_MODE1 0x00
+#define PCA9685_MODE2 0x01
+#define PCA9685_LED0_ON_L 0x06
+#define PCA9685_PRESCALE 0xFE
+#define PCA9685_MODE1_RESTART 0x80
+#define PCA9685_MODE1_AI 0x20      // Register auto-increment
+#define PCA9685_MODE1_SLEEP 0x10
+#define PCA9685_MODE2_OUTDRV 0x04  // Totem pole outputs for MOSFET gates
+#define PCA9685_FULL 0x10          // Bit 12 of an ON or OFF word: fully on / fully off
+#define PCA9685_OSC_HZ 25000000UL
+
+#if defined(I2C_BUFFER_LENGTH) && I2C_BUFFER_LENGTH < PCA9685_BURST_SIZE
+#error "Wire buffer too small for a PCA9685 burst"
+#endif
+
+Pca9685Backend::Pca9685Backend(uint8_t address)
+    : _address(address), _dirty(false), _present(false), _frequency(LED_PWM_FREQ), _staggered(false), _bursts(0)
+{
+    memset(_duty, 0, sizeof(_duty));
+}
+
+bool Pca9685Backend::begin()
+{
+    Wire.begin(SDA, SCL);
+    Wire.setClock(PCA9685_I2C_CLOCK);
+    Wire.beginTransmission(_address);
+    _present = Wire.endTransmission() == 0;
+    if (!_present)
+    {
+        Log.warningln("[LedCtrl] No PCA9685 at 0x%X.", _address);
+        return false;
+    }
+
+    writeRegister(PCA9685_MODE2, PCA9685_MODE2_OUTDRV);
+    writePrescale();
+    _dirty = true;
+    flush();
+    Log.infoln("[LedCtrl] PCA9685 at 0x%X, %d Hz.", _address, _frequency);
+    return true;
+}
+
+bool Pca9685Backend::setTiming(uint16_t frequencyHz, bool staggered)
+{
+    uint16_t frequency = constrain(frequencyHz, PCA9685_MIN_FREQ, PCA9685_MAX_FREQ);
+    if (frequency == _frequency && staggered == _staggered)
+        return false;
+    _staggered = staggered;
+    _dirty = true;
+    if (frequency != _frequency)
+    {
+        _frequency = frequency;
+        if (_present)
+            writePrescale();
+    }
+    flush();
+    return false; // The shadow copy is resent as is
+}
+
+void Pca9685Backend::writePrescale()
+{
+    // The prescaler can only be written while the oscillator sleeps
+    uint8_t prescale = (PCA9685_OSC_HZ + 2048UL * _frequency) / (4096UL * _frequency) - 1;
+    writeRegister(PCA9685_MODE1, PCA9685_MODE1_SLEEP | PCA9685_MODE1_AI);
+    writeRegister(PCA9685_PRESCALE, prescale);
+    writeRegister(PCA9685_MODE1, PCA9685_MODE1_AI);
+    delayMicroseconds(500); // Oscillator start-up
+    writeRegister(PCA9685_MODE1, PCA9685_MODE1_AI | PCA9685_MODE1_RESTART);
+}
+
+void Pca9685Backend::end(uint16_t offDuty)
+{
+    if (!_present)
+        return;
+    for (int i = 0; i < PCA9685_CHANNELS; i++)
+        _duty[i] = offDuty;
+    _dirty = true;
+    flush();
+    writeRegister(PCA9685_MODE1, PCA9685_MODE1_SLEEP | PCA9685_MODE1_AI);
+    _present = false;
+}
+
+void Pca9685Backend::write(uint8_t output, uint16_t duty)
+{
+    if (output >= PCA9685_CHANNELS || _duty[output] == duty)
+        return;
+    _duty[output] = duty;
+    _dirty = true;
+}
+
+void Pca9685Backend::flush()
+{
+    if (!_dirty || !_present)
+        return;
+    uint8_t burst[PCA9685_BURST_SIZE];
+    buildBurst(_duty, _staggered, burst);
+    Wire.beginTransmission(_address);
+    Wire.write(burst, sizeof(burst));
+    if (Wire.endTransmission() != 0)
+    {
+        Log.warningln("[LedCtrl] PCA9685 write failed.");
+        return; // Stay dirty, the next flush retries
+    }
+    _dirty = false;
+    _bursts++;
+}
+
+void Pca9685Backend::buildBurst(const uint16_t *duty, bool staggered, uint8_t *out)
+{
+    *out++ = PCA9685_LED0_ON_L;
+    for (int i = 0; i < PCA9685_CHANNELS; i++)
+    {
+        // The counter wraps at 4096, so an OFF time past the end lands early in the next period
+        uint16_t on = staggered ? i * (4096 / PCA9685_CHANNELS) : 0;
+        uint16_t off = (on + duty[i]) & 0x0FFF;
+        // The extremes use the full-on / full-off bits so there is no 1/4096 glitch
+        if (duty[i] == 0)
+            off = PCA9685_FULL << 8;
+        else if (duty[i] >= LED_DUTY_MAX)
+        {
+            on = PCA9685_FULL << 8;
+            off = 0;
+        }
+        *out++ = on & 0xFF;
+        *out++ = on >> 8;
+        *out++ = off & 0xFF;
+        *out++ = off >> 8;
+    }
+}
+
+bool Pca9685Backend::writeRegister(uint8_t reg, uint8_t value)
+{
+    Wire.beginTransmission(_address);
+    Wire.write(reg);
+    Wire.write(value);
+    return Wire.endTransmission() == 0;
+}
@@ -0,0 +1,51 @@
+#ifndef PCA9685_BACKEND_H
+#define PCA9685_BACKEND_H
+
+#include <Arduino.h>
+#include "LedBackend.h"
+
+#define PCA9685_CHANNELS 16
+#define PCA9685_MIN_FREQ 24
+#define PCA9685_MAX_FREQ 1526
+#define PCA9685_I2C_CLOCK 400000  // Fast mode
+#define PCA9685_BURST_SIZE (1 + PCA9685_CHANNELS * 4) // Start register plus ON/OFF words for every channel
+
+/**
+ * PCA9685 16-channel, 12-bit I2C PWM expander on D2 (SDA) / D1 (SCL).
+ * write() only updates a shadow copy; flush() sends all 16 channels in one
+ * auto-increment burst, and only when a duty changed. Staggering uses the
+ * chip's per-channel ON time, spreading channel n to n/16 of the period.
+ */
+class Pca9685Backend : public LedBackend
+{
+public:
+    explicit Pca9685Backend(uint8_t address);
+    bool begin() override;
+    void end(uint16_t offDuty) override;
+    bool setTiming(uint16_t frequencyHz, bool staggered) override;
+    void write(uint8_t output, uint16_t duty) override;
+    void flush() override;
+    const char *name() const override { return "pca9685"; }
+    uint8_t getAddress() const { return _address; }
+    uint32_t getBursts() const { return _bursts; }
+
+    /**
+     * @brief Encodes LED0_ON_L onwards for all channels; no I/O, so it can be checked off-target.
+     * @param out PCA9685_BURST_SIZE bytes.
+     */
+    static void buildBurst(const uint16_t *duty, bool staggered, uint8_t *out);
+
+private:
+    uint8_t _address;
+    uint16_t _duty[PCA9685_CHANNELS];
+    bool _dirty;
+    bool _present;
+    uint16_t _frequency;
+    bool _staggered;
+    uint32_t _bursts;
+
+    bool writeRegister(uint8_t reg, uint8_t value);
+    void writePrescale();
+};
+
+#endif // PCA9685_BACKEND_H
@@ -0,0 +1,112 @@
+#include "Profiler.h"
+#include <string.h>
+
+Profiler::Zone Profiler::_zones[PROFILER_MAX_ZONES];
+size_t Profiler::_zoneCount = 0;
+
+uint8_t Profiler::zone(const char *name)
+{
+    for (size_t i = 0; i < _zoneCount; i++)
+    {
+        if (strcmp(_zones[i].name, name) == 0)
+            return i;
+    }
+    if (_zoneCount >= PROFILER_MAX_ZONES)
+        return 0xFF;
+    Zone &zone = _zones[_zoneCount];
+    memset(&zone, 0, sizeof(zone));
+    zone.name = name;
+    zone.minTicks = UINT32_MAX;
+    return _zoneCount++;
+}
+
+void Profiler::record(uint8_t zone, uint32_t ticks)
+{
+    if (zone >= _zoneCount)
+        return;
+    Zone &z = _zones[zone];
+    z.count++;
+    z.totalTicks += ticks;
+    if (ticks < z.minTicks)
+        z.minTicks = ticks;
+    if (ticks > z.maxTicks)
+        z.maxTicks = ticks;
+    if (++z.histogram[bucket(ticks)] == UINT16_MAX)
+    {
+        for (uint8_t i = 0; i < PROFILER_BUCKETS; i++)
+            z.histogram[i] >>= 1;
+    }
+}
+
+uint8_t Profiler::bucket(uint32_t ticks)
+{
+    if (ticks < PROFILER_SUB_BUCKETS)
+        return ticks;
+    // Values in [2^e, 2^(e+1)) take PROFILER_SUB_BUCKETS buckets, picked by the bits below the top one
+    uint8_t exponent = 31 - __builtin_clz(ticks);
+    if (exponent >= PROFILER_MAX_BITS)
+        return PROFILER_BUCKETS - 1;
+    uint8_t sub = (ticks >> (exponent - PROFILER_SUB_BITS)) & (PROFILER_SUB_BUCKETS - 1);
+    return ((exponent - PROFILER_SUB_BITS + 1) << PROFILER_SUB_BITS) + sub;
+}
+
+uint32_t Profiler::bucketUpper(uint8_t bucket)
+{
+    if (bucket < PROFILER_SUB_BUCKETS)
+        return bucket;
+    uint8_t shift = (bucket >> PROFILER_SUB_BITS) - 1;
+    uint32_t lower = (uint32_t)(PROFILER_SUB_BUCKETS + (bucket & (PROFILER_SUB_BUCKETS - 1))) << shift;
+    return lower + (1UL << shift) - 1;
+}
+
+void Profiler::reset()
+{
+    for (size_t i = 0; i < _zoneCount; i++)
+    {
+        const char *name = _zones[i].name;
+        memset(&_zones[i], 0, sizeof(Zone));
+        _zones[i].name = name;
+        _zones[i].minTicks = UINT32_MAX;
+    }
+}
+
+size_t Profiler::getZoneCount()
+{
+    return _zoneCount;
+}
+
+const Profiler::Zone &Profiler::getZone(size_t index)
+{
+    return _zones[index];
+}
+
+uint32_t Profiler::ticksPerMicrosecond()
+{
+#ifdef ARDUINO
+    return ESP.getCpuFreqMHz();
+#else
+    return 1000; // Nanosecond ticks
+#endif
+}
+
+uint32_t Profiler::percentile(const Zone &zone, float fraction)
+{
+    if (zone.count == 0)
+        return 0;
+    // Halving may have scaled the histogram down, so count its own samples
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < PROFILER_BUCKETS; i++)
+        total += zone.histogram[i];
+    uint32_t target = (uint32_t)(total * fraction);
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < PROFILER_BUCKETS; i++)
+    {
+        seen += zone.histogram[i];
+        if (seen > target)
+        {
+            uint32_t upper = bucketUpper(i);
+            return upper < zone.maxTicks ? upper : zone.maxTicks;
+        }
+    }
+    return zone.maxTicks;
+}
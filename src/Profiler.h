@@ -0,0 +1,97 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PROFILER_MAX_ZONES 16
+#define PROFILER_SUB_BITS 2 // Each power of two is split into 2^PROFILER_SUB_BITS buckets
+#define PROFILER_SUB_BUCKETS (1 << PROFILER_SUB_BITS)
+#define PROFILER_MAX_BITS 26 // Samples of 2^26 cycles (0.4 s at 160 MHz) and up share the top bucket
+#define PROFILER_BUCKETS ((PROFILER_MAX_BITS - PROFILER_SUB_BITS + 1) * PROFILER_SUB_BUCKETS)
+#define PROFILER_RESOLUTION_PCT (100 / PROFILER_SUB_BUCKETS) // Worst-case percentile overstatement
+
+/**
+ * Fixed-table hot-path profiler. PROFILE_ZONE("name") times the enclosing
+ * scope in CPU cycles (ESP.getCycleCount() on the device, clock_gettime on a
+ * native build) and records count, min, max, total and a histogram.
+ *
+ * The histogram is log-linear: every power of two is split into
+ * PROFILER_SUB_BUCKETS equal buckets, so a percentile (the upper end of its
+ * bucket) is at most PROFILER_RESOLUTION_PCT (25%) above the true value.
+ * Values below PROFILER_SUB_BUCKETS are exact. Bucket counts are 16 bit;
+ * when one fills up all of them are halved, which keeps their proportions.
+ *
+ * Build with -DPROFILER_DISABLED to compile the zones out.
+ */
+class Profiler
+{
+public:
+    struct Zone
+    {
+        const char *name;
+        uint32_t count;
+        uint32_t minTicks;
+        uint32_t maxTicks;
+        uint64_t totalTicks;
+        uint16_t histogram[PROFILER_BUCKETS];
+    };
+
+    class Scope
+    {
+    public:
+        Scope(uint8_t zone) : _zone(zone), _start(Profiler::ticks()) {}
+        ~Scope() { Profiler::record(_zone, Profiler::ticks() - _start); }
+
+    private:
+        uint8_t _zone;
+        uint32_t _start;
+    };
+
+    // Returns the zone index for a name, registering it on first use (0xFF when full)
+    static uint8_t zone(const char *name);
+    static void record(uint8_t zone, uint32_t ticks);
+    static void reset();
+    static size_t getZoneCount();
+    static const Zone &getZone(size_t index);
+    static uint32_t ticksPerMicrosecond();
+    // Upper bound, in ticks, of the bucket holding the given fraction (0..1) of samples
+    static uint32_t percentile(const Zone &zone, float fraction);
+    static uint8_t bucket(uint32_t ticks);
+    static uint32_t bucketUpper(uint8_t bucket);
+
+    static inline uint32_t ticks();
+
+private:
+    static Zone _zones[PROFILER_MAX_ZONES];
+    static size_t _zoneCount;
+};
+
+#ifdef ARDUINO
+#include <Arduino.h>
+inline uint32_t Profiler::ticks()
+{
+    return ESP.getCycleCount();
+}
+#else
+#include <time.h>
+inline uint32_t Profiler::ticks()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+#endif
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef PROFILER_DISABLED
+#define PROFILE_ZONE(name)
+#else
+#define PROFILE_ZONE(name)                                                          \
+    static const uint8_t PROFILE_CONCAT(_profileZone, __LINE__) = Profiler::zone(name); \
+    Profiler::Scope PROFILE_CONCAT(_profileScope, __LINE__)(PROFILE_CONCAT(_profileZone, __LINE__))
+#endif
+
+#endif // PROFILER_H
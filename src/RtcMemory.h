@@ -0,0 +1,26 @@
+#ifndef RTC_MEMORY_H
+#define RTC_MEMORY_H
+
+// Layout of the 512 bytes of user RTC memory, addressed in 4 byte blocks for
+// ESP.rtcUserMemoryRead/Write. Contents survive soft resets and watchdog
+// resets but not power loss. Blocks 0-31 are used by the OTA boot command.
+#define RTC_BLOCK_BOOT_STATE 32 // 8 blocks (32 bytes): last LED duty cycles and clock, see BootState
+#define RTC_BLOCK_WIFI_CACHE 40 // 9 blocks (36 bytes): last AP and IP lease, see WiFiConnector
+#define RTC_BLOCK_LOG_RING 64 // 64 blocks (256 bytes): tail of the log, see CrashLog
+
+#include <stddef.h>
+#include <stdint.h>
+
+// FNV-1a, used to tell valid records from whatever RTC memory holds after power-on
+inline uint32_t rtcChecksum(const void *data, size_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+#endif // RTC_MEMORY_H
@@ -1,20 +1,22 @@
 #include "Scheduler.h"
 #include <ArduinoLog.h>
+#include "LogToken.h"
+#include "Profiler.h"
 
 const int INVERTING_LOGIC = true;
 
-Scheduler::Scheduler()
+Scheduler::Scheduler() : _lastSceneMinute(-1)
 {
     // default constructor
 }
-Scheduler::Scheduler(DeviceSettings &settings)
+Scheduler::Scheduler(DeviceSettings &settings) : _lastSceneMinute(-1)
 {
     this->settings = settings;
 }
 void Scheduler::updateSchedule(const DeviceSettings &settings)
 {
     this->settings = settings;
-    Log.infoln("[Scheduler] Schedule updated with new settings.");
+    LOGT_INFO("[Scheduler] Schedule updated with new settings.");
 }
 
 int Scheduler::timeToMinutes(int hour, int minute)
@@ -24,18 +26,19 @@ int Scheduler::timeToMinutes(int hour, int minute)
 
 std::vector<SchedulerAction> Scheduler::checkSchedule(int currentHour, int currentMinute)
 {
+    PROFILE_ZONE("scheduler.check");
     std::vector<SchedulerAction> actions;
     // Log when the function is called and with what parameters
     for (ChannelSetting &channel : settings.channels)
     {
         if (channel.scheduleEnabled)
         {
-            Log.info("[Scheduler] Checking schedule for channel: %s\n", channel.pin.c_str());
-            Log.infoln("--- Scheduler Check ---");
-            Log.infoln("[Scheduler] Current Time: %d:%02d", currentHour, currentMinute);
+            LOGT_INFO("[Scheduler] Checking schedule for channel: %s", channel.pin.c_str());
+            LOGT_INFO("--- Scheduler Check ---");
+            LOGT_INFO("[Scheduler] Current Time: %d:%02d", currentHour, currentMinute);
 
             bool effectiveState = INVERTING_LOGIC ? !channel.state : channel.state;
-            Log.infoln("[Scheduler] Current State: %s", effectiveState ? "ON" : "OFF");
+            LOGT_INFO("[Scheduler] Current State: %s", effectiveState ? "ON" : "OFF");
 
             int _startHour = channel.startTime.substring(0, 2).toInt();
             int _startMinute = channel.startTime.substring(3, 5).toInt();
@@ -47,7 +50,7 @@ std::vector<SchedulerAction> Scheduler::checkSchedule(int currentHour, int curre
             int endInMinutes = timeToMinutes(_endHour, _endMinute);
 
             // Log the calculated time values for debugging
-            Log.infoln("[Scheduler] In Minutes -> Now: %d | Start: %d | End: %d", nowInMinutes, startInMinutes, endInMinutes);
+            LOGT_INFO("[Scheduler] In Minutes -> Now: %d | Start: %d | End: %d", nowInMinutes, startInMinutes, endInMinutes);
 
             bool shouldBeOn = false;
 
@@ -58,7 +61,7 @@ std::vector<SchedulerAction> Scheduler::checkSchedule(int currentHour, int curre
                 {
                     shouldBeOn = true;
                 }
-                Log.infoln("[Scheduler] Logic: Normal Day. Should be ON: %s", shouldBeOn ? "Yes" : "No");
+                LOGT_INFO("[Scheduler] Logic: Normal Day. Should be ON: %s", shouldBeOn ? "Yes" : "No");
             }
             else
             {
@@ -67,12 +70,12 @@ std::vector<SchedulerAction> Scheduler::checkSchedule(int currentHour, int curre
                 {
                     shouldBeOn = true;
                 }
-                Log.infoln("[Scheduler] Logic: Overnight. Should be ON: %s", shouldBeOn ? "Yes" : "No");
+                LOGT_INFO("[Scheduler] Logic: Overnight. Should be ON: %s", shouldBeOn ? "Yes" : "No");
             }
 
             if (shouldBeOn)
             {
-                Log.infoln("[Scheduler] Result: State mismatch. Sending TURN_ON.");
+                LOGT_INFO("[Scheduler] Result: State mismatch. Sending TURN_ON.");
                 SchedulerAction action;
                 action.channel = channel.pin;
                 action.stateOnOFF = true;
@@ -81,7 +84,7 @@ std::vector<SchedulerAction> Scheduler::checkSchedule(int currentHour, int curre
             }
             else
             {
-                Log.infoln("[Scheduler] Result: State mismatch. Sending TURN_OFF.");
+                LOGT_INFO("[Scheduler] Result: State mismatch. Sending TURN_OFF.");
                 SchedulerAction action;
                 action.channel = channel.pin;
                 action.stateOnOFF = false;
@@ -96,4 +99,22 @@ std::vector<SchedulerAction> Scheduler::checkSchedule(int currentHour, int curre
     }
 
     return actions;
-}
\ No newline at end of file
+}
+
+int Scheduler::checkScenes(int currentHour, int currentMinute)
+{
+    int nowInMinutes = timeToMinutes(currentHour, currentMinute);
+    if (nowInMinutes == _lastSceneMinute)
+        return -1;
+    _lastSceneMinute = nowInMinutes;
+    for (size_t i = 0; i < settings.scenes.size(); i++)
+    {
+        const String &time = settings.scenes[i].time;
+        if (time.length() == 5 && timeToMinutes(time.substring(0, 2).toInt(), time.substring(3, 5).toInt()) == nowInMinutes)
+        {
+            LOGT_INFO("[Scheduler] Scene %d due at %d:%02d", (int)i, currentHour, currentMinute);
+            return i;
+        }
+    }
+    return -1;
+}
@@ -19,8 +19,14 @@ public:
     void updateSchedule(const DeviceSettings& settings);
     std::vector<SchedulerAction> checkSchedule(int currentHour, int currentMinute);
 
+    /**
+     * @brief Scene to recall this minute, -1 if none. Fires once per minute.
+     */
+    int checkScenes(int currentHour, int currentMinute);
+
 private:
     DeviceSettings settings;
+    int _lastSceneMinute;
     int timeToMinutes(int hour, int minute);
 };
 
@@ -2,11 +2,16 @@
 #include <ArduinoJson.h>
 #include <ArduinoLog.h>
 #include <EEPROM.h>
+#include <coredecls.h> // crc32()
 #include <string.h>
+#include "Profiler.h"
 
 #define MDNS_NAME_EEPROM_ADDR 0
 const String default_mDNSName = "ledbar";
-#define JSON_BUFFER_SIZE 2048 // more the channels greater the size, 1024 per 4 channels approx
+#define JSON_BUFFER_SIZE 3072 // more the channels greater the size, 1024 per 4 channels approx, ~100 per scene
+#define SECRETS_FILE "/secrets.json" // Passwords, kept out of settings.json because that file is downloadable
+#define SECRETS_BUFFER_SIZE 1024
+#define SETTINGS_FILE "/settings.json"
 
 SettingsManager::SettingsManager()
 {
@@ -26,6 +31,7 @@ void SettingsManager::begin()
         if (!loadSettings())
         {
             Log.infoln("[Settings] No settings file found or file corrupted, creating default settings.");
+            seedDefaultNetwork(settings);
             saveSettings();
         }
     }
@@ -37,10 +43,33 @@ void SettingsManager::begin()
 
 bool SettingsManager::loadSettings()
 {
-    File configFile = LittleFS.open("/settings.json", "r");
+    bool plaintextSecrets = false;
+    if (!readSettings(SETTINGS_FILE, settings, plaintextSecrets))
+        return false;
+    loadMDNSNameFromEEPROM();
+
+    Log.infoln("[Settings] Settings loaded successfully.");
+    if (plaintextSecrets)
+    {
+        Log.infoln("[Settings] Moving passwords out of settings.json.");
+        saveSettings();
+    }
+    return true;
+}
+
+bool SettingsManager::readSettingsFile(const String &path, DeviceSettings &target)
+{
+    // Passwords found in the file are kept; saving target moves them to the secrets file
+    bool plaintextSecrets = false;
+    return readSettings(path, target, plaintextSecrets);
+}
+
+bool SettingsManager::readSettings(const String &path, DeviceSettings &target, bool &plaintextSecrets)
+{
+    File configFile = LittleFS.open(path, "r");
     if (!configFile)
     {
-        Log.infoln("[Settings] Failed to open config file for reading.");
+        Log.infoln("[Settings] Failed to open %s for reading.", path.c_str());
         return false;
     }
 
@@ -56,52 +85,225 @@ bool SettingsManager::loadSettings()
         Log.infoln(error.c_str());
         return false;
     }
+    if (!doc["channels"].is<JsonArray>())
+    {
+        Log.infoln("[Settings] %s has no channels array.", path.c_str());
+        return false;
+    }
 
     // Load scheduler settings, providing defaults if keys are missing
-    settings.gmtOffsetSeconds = doc["gmt_offset"] | 19800; // Default to IST if not present
-    settings.irCodeBrightnessUp = doc["irCodeBrightnessUp"] | "";
-    settings.irCodeBrightnessDown = doc["irCodeBrightnessDown"] | "";
-    loadMDNSNameFromEEPROM();
+    target.gmtOffsetSeconds = doc["gmt_offset"] | 19800; // Default to IST if not present
+    target.timezone = doc["timezone"] | "";
+    target.groupId = doc["groupId"] | 1;
+    target.mqttHost = doc["mqttHost"] | "";
+    target.mqttPort = doc["mqttPort"] | 1883;
+    target.mqttUser = doc["mqttUser"] | "";
+    target.mqttPassword = doc["mqttPassword"] | ""; // Normally in the secrets file, see below
+    target.mqttTopic = doc["mqttTopic"] | "";
+    target.dmxProtocol = doc["dmxProtocol"] | "off";
+    target.dmxUniverse = doc["dmxUniverse"] | 1;
+    target.dmxStartSlot = doc["dmxStartSlot"] | 1;
+    target.pwmBackend = doc["pwmBackend"] | "analog";
+    target.pwmFrequency = doc["pwmFrequency"] | 256;
+    target.pwmStagger = doc["pwmStagger"] | false;
+    target.pca9685Address = doc["pca9685Address"] | 0;
+    target.irCodeBrightnessUp = parseIrCode(doc["irCodeBrightnessUp"] | "");
+    target.irCodeBrightnessDown = parseIrCode(doc["irCodeBrightnessDown"] | "");
+
+    // Load known WiFi networks. Passwords, these and MQTT's, come from the secrets file;
+    // one found in settings.json (older firmware or an uploaded file) is taken and moved there.
+    target.networks.clear();
+    for (JsonObject networkJson : doc["networks"].as<JsonArray>())
+    {
+        WifiNetwork network;
+        network.ssid = networkJson["ssid"].as<String>();
+        network.password = networkJson["password"] | "";
+        plaintextSecrets |= network.password.length() > 0;
+        if (network.ssid.length() > 0)
+            target.networks.push_back(network);
+    }
+    plaintextSecrets |= target.mqttPassword.length() > 0;
+    loadSecrets(target);
+    seedDefaultNetwork(target);
+
+    // Load scenes
+    target.scenes.clear();
+    for (JsonObject sceneJson : doc["scenes"].as<JsonArray>())
+    {
+        Scene scene;
+        scene.name = sceneJson["name"].as<String>();
+        parseLevels(sceneJson["levels"] | "", scene.levels);
+        scene.irCode = parseIrCode(sceneJson["ir"] | "");
+        scene.time = sceneJson["time"] | "";
+        if (scene.name.length() > 0 && target.scenes.size() < SCENE_MAX)
+            target.scenes.push_back(scene);
+    }
 
     // Load channel settings
-    settings.channels.clear(); // Clear existing channels before loading new ones
+    target.channels.clear(); // Clear existing channels before loading new ones
     JsonArray channelsArray = doc["channels"].as<JsonArray>();
     for (JsonObject channelJson : channelsArray)
     {
         ChannelSetting ch;
         ch.pin = channelJson["pin"].as<String>();
         ch.channelName = channelJson["channelName"].as<String>();
-        ch.irCode = channelJson["irCode"].as<String>();
+        ch.irCode = parseIrCode(channelJson["irCode"] | "");
         ch.state = channelJson["state"];
         ch.brightness = channelJson["brightness"];
         ch.scheduleEnabled = doc["sch_en"] | true;
         ch.startTime = doc["sch_s"] | "19:00";
         ch.endTime = doc["sch_e"] | "23:30";
         ch.scheduledBrightness = doc["sch_brightness"] | 80;
-        settings.channels.push_back(ch);
+        target.channels.push_back(ch);
     }
 
-    Log.infoln("[Settings] Settings loaded successfully.");
     return true;
 }
 
-bool SettingsManager::saveSettings()
+void SettingsManager::loadSecrets(DeviceSettings &target)
 {
-    File configFile = LittleFS.open("/settings.json", "w");
-    if (!configFile)
+    File secretsFile = LittleFS.open(SECRETS_FILE, "r");
+    if (!secretsFile)
+        return;
+
+    DynamicJsonDocument doc(SECRETS_BUFFER_SIZE);
+    DeserializationError error = deserializeJson(doc, secretsFile);
+    secretsFile.close();
+    if (error)
     {
-        Log.infoln("[Settings] Failed to open config file for writing.");
+        Log.infoln("[Settings] Secrets file unreadable: %s", error.c_str());
+        return;
+    }
+    _secretsCrc = secretsCrc(doc);
+
+    // Matched by SSID, so an uploaded settings.json without passwords keeps the stored ones
+    for (auto &network : target.networks)
+    {
+        if (network.password.length() > 0)
+            continue;
+        for (JsonObject networkJson : doc["networks"].as<JsonArray>())
+        {
+            if (network.ssid == (networkJson["ssid"] | ""))
+                network.password = networkJson["password"] | "";
+        }
+    }
+    if (target.mqttPassword.length() == 0)
+        target.mqttPassword = doc["mqttPassword"] | "";
+}
+
+uint32_t SettingsManager::secretsCrc(const JsonDocument &doc)
+{
+    String json;
+    serializeJson(doc, json);
+    return crc32(json.c_str(), json.length());
+}
+
+bool SettingsManager::saveSecrets()
+{
+    DynamicJsonDocument doc(SECRETS_BUFFER_SIZE);
+    JsonArray networks = doc.createNestedArray("networks");
+    for (const auto &network : settings.networks)
+    {
+        JsonObject networkJson = networks.createNestedObject();
+        networkJson["ssid"] = network.ssid;
+        networkJson["password"] = network.password;
+    }
+    doc["mqttPassword"] = settings.mqttPassword;
+
+    // Every toggle, ramp step or scene recall saves the settings; the secrets
+    // rarely change with them, so only rewrite them when they did
+    uint32_t crc = secretsCrc(doc);
+    if (crc == _secretsCrc)
+        return true;
+    if (!writeFile(SECRETS_FILE, doc))
         return false;
+    _secretsCrc = crc;
+    return true;
+}
+
+void SettingsManager::seedDefaultNetwork(DeviceSettings &target)
+{
+#ifdef WIFI_DEFAULT_SSID
+    // Build-time credentials only bootstrap a device that has no networks stored yet
+    if (target.networks.empty())
+    {
+        WifiNetwork network;
+        network.ssid = WIFI_DEFAULT_SSID;
+#ifdef WIFI_DEFAULT_PASSWORD
+        network.password = WIFI_DEFAULT_PASSWORD;
+#endif
+        target.networks.push_back(network);
+        Log.infoln("[Settings] Added default network %s.", network.ssid.c_str());
     }
+#endif
+}
 
+bool SettingsManager::writeFile(const char *path, const JsonDocument &doc)
+{
+    // Written next to the target, then renamed over it: LittleFS replaces the
+    // destination atomically, so a reset leaves either the old or the new file
+    String tmpPath = String(path) + ".new";
+    File file = LittleFS.open(tmpPath, "w");
+    if (!file)
+    {
+        Log.infoln("[Settings] Failed to open %s for writing.", tmpPath.c_str());
+        return false;
+    }
+    bool ok = serializeJson(doc, file) > 0;
+    file.close();
+    if (!ok || !LittleFS.rename(tmpPath, path))
+    {
+        Log.infoln("[Settings] Failed to write %s.", path);
+        LittleFS.remove(tmpPath);
+        return false;
+    }
+    return true;
+}
+
+bool SettingsManager::saveSettings()
+{
+    PROFILE_ZONE("settings.save");
     DynamicJsonDocument doc(JSON_BUFFER_SIZE);
 
     // Save scheduler settings
     doc["gmt_offset"] = settings.gmtOffsetSeconds;
-    doc["irCodeBrightnessUp"] = settings.irCodeBrightnessUp;
-    doc["irCodeBrightnessDown"] = settings.irCodeBrightnessDown;
+    doc["timezone"] = settings.timezone;
+    doc["groupId"] = settings.groupId;
+    doc["mqttHost"] = settings.mqttHost;
+    doc["mqttPort"] = settings.mqttPort;
+    doc["mqttUser"] = settings.mqttUser; // The password goes to the secrets file
+    doc["mqttTopic"] = settings.mqttTopic;
+    doc["dmxProtocol"] = settings.dmxProtocol;
+    doc["dmxUniverse"] = settings.dmxUniverse;
+    doc["dmxStartSlot"] = settings.dmxStartSlot;
+    doc["pwmBackend"] = settings.pwmBackend;
+    doc["pwmFrequency"] = settings.pwmFrequency;
+    doc["pwmStagger"] = settings.pwmStagger;
+    doc["pca9685Address"] = settings.pca9685Address;
+    doc["irCodeBrightnessUp"] = formatIrCode(settings.irCodeBrightnessUp);
+    doc["irCodeBrightnessDown"] = formatIrCode(settings.irCodeBrightnessDown);
     saveMDNSNameToEEPROM(settings.mDNSName);
 
+    // Save known WiFi networks; their passwords go to the secrets file
+    JsonArray networks = doc.createNestedArray("networks");
+    for (const auto &network : settings.networks)
+    {
+        networks.createNestedObject()["ssid"] = network.ssid;
+    }
+
+    // Save scenes
+    JsonArray scenes = doc.createNestedArray("scenes");
+    for (const auto &scene : settings.scenes)
+    {
+        JsonObject sceneJson = scenes.createNestedObject();
+        sceneJson["name"] = scene.name;
+        sceneJson["levels"] = formatLevels(scene.levels);
+        if (scene.irCode != 0)
+            sceneJson["ir"] = formatIrCode(scene.irCode);
+        if (scene.time.length() > 0)
+            sceneJson["time"] = scene.time;
+    }
+
     // Save channel settings
     JsonArray channels = doc.createNestedArray("channels");
     for (const auto &ch_setting : settings.channels)
@@ -109,7 +311,7 @@ bool SettingsManager::saveSettings()
         JsonObject channel = channels.createNestedObject();
         channel["pin"] = ch_setting.pin;
         channel["channelName"] = ch_setting.channelName;
-        channel["irCode"] = ch_setting.irCode;
+        channel["irCode"] = formatIrCode(ch_setting.irCode);
         channel["state"] = ch_setting.state;
         channel["brightness"] = ch_setting.brightness;
         channel["sch_en"] = ch_setting.scheduleEnabled;
@@ -118,14 +320,10 @@ bool SettingsManager::saveSettings()
         channel["sch_brightness"] = ch_setting.scheduledBrightness;
     }
 
-    if (serializeJson(doc, configFile) == 0)
-    {
-        Log.infoln(F("[Settings] Failed to write to config file."));
-        configFile.close();
+    if (!writeFile(SETTINGS_FILE, doc))
+        return false;
+    if (!saveSecrets())
         return false;
-    }
-
-    configFile.close();
     Log.infoln("[Settings] Settings saved successfully.");
     return true;
 }
@@ -135,6 +333,66 @@ DeviceSettings &SettingsManager::getSettings()
     return settings;
 }
 
+uint64_t SettingsManager::parseIrCode(const char *hex)
+{
+    if (hex == nullptr || *hex == '\0')
+        return 0;
+    return strtoull(hex, nullptr, 16);
+}
+
+String SettingsManager::formatIrCode(uint64_t code)
+{
+    if (code == 0)
+        return "";
+    String hex = String(code, HEX);
+    hex.toUpperCase();
+    return hex;
+}
+
+int SettingsManager::findScene(const String &name)
+{
+    for (size_t i = 0; i < settings.scenes.size(); i++)
+    {
+        if (settings.scenes[i].name == name)
+            return i;
+    }
+    return -1;
+}
+
+void SettingsManager::captureScene(const DeviceSettings &settings, Scene &scene)
+{
+    scene.levels.clear();
+    for (const auto &channel : settings.channels)
+    {
+        scene.levels.push_back((channel.state ? SCENE_STATE_BIT : 0) | constrain(channel.brightness, 0, 100));
+    }
+}
+
+String SettingsManager::formatLevels(const std::vector<uint8_t> &levels)
+{
+    // Two hex digits per channel keeps a scene a few bytes in settings.json
+    static const char digits[] = "0123456789abcdef";
+    String hex;
+    hex.reserve(levels.size() * 2);
+    for (uint8_t level : levels)
+    {
+        hex += digits[level >> 4];
+        hex += digits[level & 0x0F];
+    }
+    return hex;
+}
+
+void SettingsManager::parseLevels(const char *hex, std::vector<uint8_t> &levels)
+{
+    levels.clear();
+    size_t length = strlen(hex);
+    for (size_t i = 0; i + 1 < length; i += 2)
+    {
+        char pair[3] = {hex[i], hex[i + 1], '\0'};
+        levels.push_back(strtoul(pair, nullptr, 16));
+    }
+}
+
 bool SettingsManager::loadMDNSNameFromEEPROM()
 {
     String storedMDNSName = "";
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <LittleFS.h>
+#include <ArduinoJson.h>
 #include <vector>
 
 // A struct to hold settings for a single PWM channel
@@ -10,7 +11,7 @@ struct ChannelSetting
 {
   String pin;
   String channelName;
-  String irCode;
+  uint64_t irCode = 0; // Stored as hex in settings.json, 0 when unbound
   bool state;
   int brightness;
   bool scheduleEnabled = false;
@@ -20,14 +21,50 @@ struct ChannelSetting
   bool schedulerActive = false; // Indicates if the scheduler is active for this channel
 };
 
+// A known WiFi network; the connector joins the strongest one in range
+struct WifiNetwork
+{
+  String ssid;
+  String password;
+};
+
+#define SCENE_MAX 8         // Named scenes stored in settings
+#define SCENE_STATE_BIT 0x80 // Scene level byte: bit 7 state, bits 0-6 brightness
+#define SCENE_FADE_MS 800    // Cross-fade for recalls that don't ask for one (IR, schedule)
+
+// A named snapshot of every channel, stored as one level byte per channel
+struct Scene
+{
+  String name;
+  std::vector<uint8_t> levels;
+  uint64_t irCode = 0; // Recalls the scene, 0 when unbound
+  String time = "";    // Recalled daily at "HH:MM", empty for none
+};
+
 // The main settings struct for the device
 struct DeviceSettings
 {
   std::vector<ChannelSetting> channels;
+  std::vector<WifiNetwork> networks;
+  std::vector<Scene> scenes;
   long gmtOffsetSeconds = 19800; // Default to IST (+5:30)
+  String timezone = "";          // POSIX TZ rule with DST, overrides gmtOffsetSeconds when set
   String mDNSName = "ledbar";
-  String irCodeBrightnessUp;
-  String irCodeBrightnessDown;
+  uint64_t irCodeBrightnessUp = 0;
+  uint64_t irCodeBrightnessDown = 0;
+  uint16_t groupId = 1; // Multicast group this device answers to, besides group 0 (all)
+  String mqttHost = "";  // MQTT broker, empty disables MQTT
+  uint16_t mqttPort = 1883;
+  String mqttUser = "";
+  String mqttPassword = "";
+  String mqttTopic = ""; // Base topic, defaults to ledbar/<mDNSName>
+  String dmxProtocol = "off"; // Live DMX input: "off", "e131" or "artnet"
+  uint16_t dmxUniverse = 1;
+  uint16_t dmxStartSlot = 1; // Slot (1-512) driving the first channel, the rest follow in order
+  String pwmBackend = "analog"; // GPIO PWM: "analog" (core analogWrite) or "soft" (timer ISR, adds D0)
+  uint16_t pwmFrequency = 256;  // Hz, each backend clamps it to its own range
+  bool pwmStagger = false;      // Spread channel phases over the period (software PWM and PCA9685)
+  uint8_t pca9685Address = 0; // I2C address of a PCA9685 expander (pins P0-P15), 0 when none
   // Remove old single-channel properties like ledState, brightness
 };
 
@@ -38,13 +75,27 @@ public:
   void begin();
   bool loadSettings();
   bool saveSettings();
+  bool readSettingsFile(const String &path, DeviceSettings &target);
   DeviceSettings &getSettings();
   bool loadMDNSNameFromEEPROM();
+  static uint64_t parseIrCode(const char *hex);
+  static String formatIrCode(uint64_t code);
+  int findScene(const String &name);
+  static void captureScene(const DeviceSettings &settings, Scene &scene);
+  static String formatLevels(const std::vector<uint8_t> &levels);
+  static void parseLevels(const char *hex, std::vector<uint8_t> &levels);
   void saveMDNSNameToEEPROM(const String &mDNSName);
 
 private:
   DeviceSettings settings;
+  uint32_t _secretsCrc = 0; // Of the secrets file as last read or written
   bool mountFS();
+  bool writeFile(const char *path, const JsonDocument &doc);
+  bool readSettings(const String &path, DeviceSettings &target, bool &plaintextSecrets);
+  void seedDefaultNetwork(DeviceSettings &target);
+  void loadSecrets(DeviceSettings &target);
+  bool saveSecrets();
+  static uint32_t secretsCrc(const JsonDocument &doc);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "SoftPwmBackend.h"
+#include <ArduinoLog.h>
+
+#define SOFT_PWM_GPIO16_BIT (1UL << 16)
+
+SoftPwmBackend *SoftPwmBackend::_instance = nullptr;
+
+SoftPwmBackend::SoftPwmBackend()
+    : _configured(0), _dirty(false), _running(false), _periodTicks(SOFT_PWM_TICKS_PER_US * 1000000UL / LED_PWM_FREQ),
+      _staggered(false), _active(0), _swap(false), _step(0), _isrCount(0), _isrMaxCycles(0), _isrTotalCycles(0)
+{
+    memset(_duty, 0, sizeof(_duty));
+    memset(_tables, 0, sizeof(_tables));
+}
+
+bool SoftPwmBackend::begin()
+{
+    if (_running)
+        return true;
+    _instance = this;
+    _step = 0;
+    _swap = false;
+    _dirty = true;
+    flush(); // Swapped in by the first interrupt
+    timer1_attachInterrupt(onTimer);
+    timer1_enable(TIM_DIV16, TIM_EDGE, TIM_SINGLE);
+    timer1_write(_periodTicks);
+    _running = true;
+    Log.infoln("[LedCtrl] Software PWM at %d Hz%s.", (int)(SOFT_PWM_TICKS_PER_US * 1000000UL / _periodTicks),
+               _staggered ? ", staggered" : "");
+    return true;
+}
+
+bool SoftPwmBackend::setTiming(uint16_t frequencyHz, bool staggered)
+{
+    uint32_t periodTicks = SOFT_PWM_TICKS_PER_US * 1000000UL / constrain(frequencyHz, SOFT_PWM_MIN_FREQ, SOFT_PWM_MAX_FREQ);
+    if (periodTicks == _periodTicks && staggered == _staggered)
+        return false;
+    // Duties are kept, the next flush() builds a table for the new timing
+    _periodTicks = periodTicks;
+    _staggered = staggered;
+    _dirty = true;
+    flush();
+    return false;
+}
+
+void SoftPwmBackend::end(uint16_t offDuty)
+{
+    if (!_running)
+        return;
+    timer1_disable();
+    timer1_detachInterrupt();
+    _running = false;
+    bool high = offDuty >= LED_DUTY_MAX;
+    if (high)
+        GPOS = _configured & 0xFFFF;
+    else
+        GPOC = _configured & 0xFFFF;
+    if (_configured & SOFT_PWM_GPIO16_BIT)
+        GP16O = high ? 1 : 0;
+    _configured = 0;
+    memset(_duty, 0, sizeof(_duty));
+}
+
+void SoftPwmBackend::write(uint8_t output, uint16_t duty)
+{
+    if (output >= SOFT_PWM_MAX_PINS)
+        return;
+    if (!(_configured & (1UL << output)))
+    {
+        pinMode(output, OUTPUT);
+        _configured |= 1UL << output;
+        _dirty = true;
+    }
+    if (_duty[output] != duty)
+    {
+        _duty[output] = duty;
+        _dirty = true;
+    }
+}
+
+void SoftPwmBackend::flush()
+{
+    if (!_dirty)
+        return;
+    _dirty = false;
+    // With no swap pending the ISR never touches the inactive table, so it can be rebuilt in place
+    _swap = false;
+    asm volatile("" ::: "memory"); // Keep the table stores between the two flag writes
+    buildTable(_duty, _configured, _periodTicks, _staggered, _tables[_active ^ 1]);
+    asm volatile("" ::: "memory");
+    _swap = true;
+}
+
+void SoftPwmBackend::buildTable(const uint16_t *duty, uint32_t configured, uint32_t period, bool staggered, Table &table)
+{
+    const uint32_t minGap = SOFT_PWM_TICKS_PER_US * SOFT_PWM_MIN_GAP_US;
+
+    // Rise and fall times of every pulsing pin; pins that are fully on or off only change at the period start
+    struct Point
+    {
+        uint32_t at;
+        uint32_t setMask;
+        uint32_t clearMask;
+    };
+    Point points[SOFT_PWM_MAX_EVENTS];
+    uint8_t count = 1;
+    points[0] = {0, 0, 0};
+
+    uint8_t driven = 0;
+    for (uint8_t pin = 0; pin < SOFT_PWM_MAX_PINS; pin++)
+    {
+        if (configured & (1UL << pin))
+            driven++;
+    }
+
+    uint8_t rank = 0;
+    uint32_t pulsing = 0;
+    for (uint8_t pin = 0; pin < SOFT_PWM_MAX_PINS; pin++)
+    {
+        uint32_t bit = 1UL << pin;
+        if (!(configured & bit))
+            continue;
+        // Phases follow pin order, not duty, so they stay put while a channel fades
+        uint32_t phase = staggered ? rank * period / driven : 0;
+        rank++;
+        if (duty[pin] == 0)
+        {
+            points[0].clearMask |= bit;
+            continue;
+        }
+        if (duty[pin] >= LED_DUTY_MAX)
+        {
+            points[0].setMask |= bit;
+            continue;
+        }
+        uint32_t on = (uint32_t)duty[pin] * period / LED_DUTY_MAX;
+        on = constrain(on, minGap, period - minGap);
+        pulsing |= bit;
+        points[count++] = {phase, bit, 0};
+        points[count++] = {(phase + on) % period, 0, bit};
+    }
+
+    // An edge too close to the period end runs with the next period's start instead
+    for (uint8_t i = 1; i < count; i++)
+    {
+        if (points[i].at > period - minGap)
+            points[i].at = 0;
+    }
+
+    // Insertion sort by time; point 0 stays first (stable, and nothing sorts below 0)
+    for (uint8_t i = 1; i < count; i++)
+    {
+        Point point = points[i];
+        uint8_t j = i;
+        while (j > 1 && points[j - 1].at > point.at)
+        {
+            points[j] = points[j - 1];
+            j--;
+        }
+        points[j] = point;
+    }
+
+    // Merge edges within minGap of an event's start. A pin's own rise and fall are
+    // at least minGap apart, so they never end up in the same event.
+    table.count = 0;
+    uint32_t eventAt = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (table.count > 0 && points[i].at - eventAt < minGap)
+        {
+            table.events[table.count - 1].setMask |= points[i].setMask;
+            table.events[table.count - 1].clearMask |= points[i].clearMask;
+            continue;
+        }
+        if (table.count > 0)
+            table.events[table.count - 1].ticks = points[i].at - eventAt;
+        table.events[table.count++] = {0, points[i].setMask, points[i].clearMask};
+        eventAt = points[i].at;
+    }
+    table.events[table.count - 1].ticks = period - eventAt;
+
+    // Restate every pulsing pin's level at the period start: high if its pulse
+    // wraps past the end, low otherwise. That is a no-op in steady state, but a
+    // table swapped in after one whose pulse wrapped would otherwise leave the
+    // pin high until its next fall, a whole period later.
+    uint32_t pending = pulsing & ~(table.events[0].setMask | table.events[0].clearMask);
+    for (uint8_t i = 1; i < table.count && pending; i++)
+    {
+        table.events[0].setMask |= table.events[i].clearMask & pending;
+        table.events[0].clearMask |= table.events[i].setMask & pending;
+        pending &= ~(table.events[i].setMask | table.events[i].clearMask);
+    }
+}
+
+void SoftPwmBackend::resetStats()
+{
+    noInterrupts();
+    _isrCount = 0;
+    _isrMaxCycles = 0;
+    _isrTotalCycles = 0;
+    interrupts();
+}
+
+void IRAM_ATTR SoftPwmBackend::onTimer()
+{
+    uint32_t start = ESP.getCycleCount();
+    SoftPwmBackend &pwm = *_instance;
+    if (pwm._step == 0 && pwm._swap)
+    {
+        pwm._active ^= 1;
+        pwm._swap = false;
+    }
+    const Table &table = pwm._tables[pwm._active];
+    const Event &event = table.events[pwm._step];
+    GPOC = event.clearMask & 0xFFFF;
+    GPOS = event.setMask & 0xFFFF;
+    if ((event.setMask | event.clearMask) & SOFT_PWM_GPIO16_BIT)
+        GP16O = (event.setMask & SOFT_PWM_GPIO16_BIT) ? 1 : 0;
+    timer1_write(event.ticks);
+    pwm._step = pwm._step + 1 < table.count ? pwm._step + 1 : 0;
+
+    uint32_t cycles = ESP.getCycleCount() - start;
+    pwm._isrCount = pwm._isrCount + 1;
+    pwm._isrTotalCycles = pwm._isrTotalCycles + cycles;
+    if (cycles > pwm._isrMaxCycles)
+        pwm._isrMaxCycles = cycles;
+}
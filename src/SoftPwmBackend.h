@@ -0,0 +1,86 @@
+#ifndef SOFT_PWM_BACKEND_H
+#define SOFT_PWM_BACKEND_H
+
+#include <Arduino.h>
+#include "LedBackend.h"
+
+#define SOFT_PWM_MIN_FREQ 100
+#define SOFT_PWM_MAX_FREQ 1000      // Hz; keeps interrupts per second bounded with every pin pulsing
+#define SOFT_PWM_MAX_PINS 17        // GPIO0..GPIO16, D0 (GPIO16) included
+#define SOFT_PWM_MAX_EVENTS (2 * SOFT_PWM_MAX_PINS + 1) // A rise and a fall per pin, plus the period start
+#define SOFT_PWM_TICKS_PER_US 5     // timer1 runs from the 80 MHz APB clock divided by 16
+#define SOFT_PWM_MIN_GAP_US 4       // Edges closer than this share one register write
+
+/**
+ * Software PWM for any GPIO from one timer1 interrupt. flush() turns the
+ * duties into a table of events sorted by time; each event raises and
+ * clears every pin due at that moment with one GPOS and one GPOC write.
+ * Without staggering all pins rise together at the period start. With it,
+ * the n-th driven pin rises n/N into the period, spreading the current
+ * draw. Edges closer than SOFT_PWM_MIN_GAP_US are merged, so the ISR runs
+ * at most 2N + 1 times per period and does constant work each time. Tables
+ * are double buffered and swapped at the start of a period, so the ISR
+ * never sees a partial one; the first event restates every pin's level, so
+ * a pulse left over from the old table cannot run on into the new one.
+ *
+ * Shares timer1 with the core's analogWrite(), so only one of the two
+ * GPIO backends may run at a time.
+ */
+class SoftPwmBackend : public LedBackend
+{
+public:
+    struct Event
+    {
+        uint32_t ticks;     // Delay until the next event
+        uint32_t setMask;   // Pins switched on here; bit 16 is GPIO16
+        uint32_t clearMask; // Pins switched off here
+    };
+
+    struct Table
+    {
+        uint8_t count; // Event 0 is the period start, always present
+        Event events[SOFT_PWM_MAX_EVENTS];
+    };
+
+    SoftPwmBackend();
+    bool begin() override;
+    void end(uint16_t offDuty) override;
+    bool setTiming(uint16_t frequencyHz, bool staggered) override;
+    void write(uint8_t output, uint16_t duty) override;
+    void flush() override;
+    const char *name() const override { return "soft"; }
+
+    // ISR cost since the last resetStats(), in CPU cycles
+    uint32_t getIsrCount() const { return _isrCount; }
+    uint32_t getIsrMaxCycles() const { return _isrMaxCycles; }
+    uint32_t getIsrAvgCycles() const { return _isrCount ? (uint32_t)(_isrTotalCycles / _isrCount) : 0; }
+    uint8_t getEventCount() const { return _tables[_active].count; }
+    void resetStats();
+
+    /**
+     * @brief Builds the event table for one period; no I/O, so it can be checked off-target.
+     * @param configured Pins to drive, bit n for GPIOn.
+     * @param period In timer1 ticks.
+     */
+    static void buildTable(const uint16_t *duty, uint32_t configured, uint32_t period, bool staggered, Table &table);
+
+private:
+    uint16_t _duty[SOFT_PWM_MAX_PINS];
+    uint32_t _configured; // Pins this backend drives
+    bool _dirty;
+    bool _running;
+    uint32_t _periodTicks;
+    bool _staggered;
+    Table _tables[2];
+    volatile uint8_t _active;
+    volatile bool _swap;
+    volatile uint8_t _step; // Next event to run, 0 at the start of a period
+    volatile uint32_t _isrCount;
+    volatile uint32_t _isrMaxCycles;
+    volatile uint64_t _isrTotalCycles;
+
+    static SoftPwmBackend *_instance;
+    static void IRAM_ATTR onTimer();
+};
+
+#endif // SOFT_PWM_BACKEND_H
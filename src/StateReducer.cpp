@@ -0,0 +1,224 @@
+#include "StateReducer.h"
+#include <ArduinoLog.h>
+#include <utility>
+
+StateReducer::StateReducer(CommandQueue &queue, SettingsManager &settingsMgr, LedController &ledCtrl,
+                           Scheduler &scheduler, TimeManager &timeMgr, IrManager &irMgr, WiFiConnector &wifi)
+    : _queue(queue), _settingsManager(settingsMgr), _ledController(ledCtrl), _scheduler(scheduler),
+      _timeManager(timeMgr), _irManager(irMgr), _wifiConnector(wifi), _dirty(false), _dirtySince(0) {}
+
+void StateReducer::process()
+{
+    DeviceSettings &settings = _settingsManager.getSettings();
+    bool ledsChanged = false;
+    bool reconfigure = false;
+    uint16_t transitionMs = 0;
+
+    Command command;
+    while (_queue.pop(command))
+    {
+        if (apply(command, settings, reconfigure))
+        {
+            ledsChanged = true;
+            transitionMs = max(transitionMs, command.transitionMs);
+        }
+        if (command.persist)
+        {
+            _dirty = true;
+            _dirtySince = millis();
+        }
+    }
+
+    if (reconfigure)
+    {
+        _timeManager.setTimezone(settings.timezone, settings.gmtOffsetSeconds);
+        _scheduler.updateSchedule(settings);
+        _irManager.updateBindings(settings);
+        _wifiConnector.setNetworks(settings.networks);
+        _ledController.configure(settings);
+    }
+    if (ledsChanged)
+    {
+        _ledController.update(settings, transitionMs);
+    }
+    if (_dirty && millis() - _dirtySince >= PERSIST_DELAY_MS)
+    {
+        flush();
+    }
+}
+
+void StateReducer::flush()
+{
+    if (!_dirty)
+        return;
+    _dirty = false;
+    _settingsManager.saveSettings();
+}
+
+bool StateReducer::apply(const Command &command, DeviceSettings &settings, bool &reconfigure)
+{
+    bool validChannel = command.channel < settings.channels.size();
+    switch (command.type)
+    {
+    case CMD_TOGGLE_CHANNEL:
+        if (!validChannel)
+            return false;
+        settings.channels[command.channel].state = !settings.channels[command.channel].state;
+        Log.infoln("[Reducer] Toggling channel %s", settings.channels[command.channel].channelName.c_str());
+        return true;
+
+    case CMD_SET_CHANNEL:
+        if (!validChannel)
+            return false;
+        return setChannel(settings.channels[command.channel], command);
+
+    case CMD_TOGGLE_ALL_CHANNELS:
+        for (auto &channel : settings.channels)
+        {
+            channel.state = !channel.state;
+        }
+        Log.infoln("[Reducer] Toggling all channels");
+        return !settings.channels.empty();
+
+    case CMD_SET_ALL_CHANNELS:
+    {
+        bool changed = false;
+        for (auto &channel : settings.channels)
+        {
+            changed |= setChannel(channel, command);
+        }
+        return changed;
+    }
+
+    case CMD_ADJUST_BRIGHTNESS:
+    {
+        bool changed = false;
+        for (auto &channel : settings.channels)
+        {
+            if (!channel.state)
+                continue;
+            int brightness = constrain(channel.brightness + command.value, 0, 100);
+            changed |= brightness != channel.brightness;
+            channel.brightness = brightness;
+        }
+        return changed;
+    }
+
+    case CMD_SCHEDULER_ACTIVE:
+    {
+        if (!validChannel)
+            return false;
+        // Only an actual edge changes the LEDs; the schedule is re-evaluated every second
+        ChannelSetting &channel = settings.channels[command.channel];
+        bool changed = channel.schedulerActive != command.state;
+        channel.schedulerActive = command.state;
+        return changed;
+    }
+
+    case CMD_BIND_IR_CODE:
+        if (command.value == IR_ACTION_BRIGHTNESS_UP)
+            settings.irCodeBrightnessUp = command.code;
+        else if (command.value == IR_ACTION_BRIGHTNESS_DOWN)
+            settings.irCodeBrightnessDown = command.code;
+        else if (command.value == IR_ACTION_TOGGLE_CHANNEL && validChannel)
+            settings.channels[command.channel].irCode = command.code;
+        else if (command.value == IR_ACTION_RECALL_SCENE && command.channel < settings.scenes.size())
+            settings.scenes[command.channel].irCode = command.code;
+        else
+            return false;
+        _irManager.updateBindings(settings);
+        return false;
+
+    case CMD_SETTINGS_CHANGED:
+        if (command.settings)
+        {
+            // The host name only changes through CMD_SET_HOSTNAME, once probing confirmed it
+            command.settings->mDNSName = settings.mDNSName;
+            settings = std::move(*command.settings);
+            delete command.settings;
+        }
+        reconfigure = true;
+        return true;
+
+    case CMD_RECALL_SCENE:
+    {
+        if (command.value < 0 || command.value >= (int)settings.scenes.size())
+            return false;
+        // Every channel changes in this one command, so the LEDs see a single update
+        const Scene &scene = settings.scenes[command.value];
+        Log.infoln("[Reducer] Recalling scene %s", scene.name.c_str());
+        bool changed = false;
+        for (size_t i = 0; i < settings.channels.size() && i < scene.levels.size(); i++)
+        {
+            ChannelSetting &channel = settings.channels[i];
+            bool state = scene.levels[i] & SCENE_STATE_BIT;
+            int brightness = scene.levels[i] & ~SCENE_STATE_BIT;
+            changed |= channel.state != state || channel.brightness != brightness;
+            channel.state = state;
+            channel.brightness = brightness;
+        }
+        return changed;
+    }
+
+    case CMD_SAVE_SCENE:
+    {
+        int index = _settingsManager.findScene(command.text);
+        if (index < 0)
+        {
+            if (command.text.length() == 0 || settings.scenes.size() >= SCENE_MAX)
+                return false;
+            Scene scene;
+            scene.name = command.text;
+            settings.scenes.push_back(scene);
+            index = settings.scenes.size() - 1;
+        }
+        SettingsManager::captureScene(settings, settings.scenes[index]);
+        // Reconfigure so the scheduler and IR bindings see the scene
+        reconfigure = true;
+        return false;
+    }
+
+    case CMD_SCHEDULE_SCENE:
+    {
+        int index = _settingsManager.findScene(command.text);
+        if (index < 0)
+            return false;
+        char time[6] = "";
+        if (command.value >= 0)
+            snprintf(time, sizeof(time), "%02d:%02d", command.value / 60, command.value % 60);
+        settings.scenes[index].time = time;
+        reconfigure = true;
+        return false;
+    }
+
+    case CMD_DELETE_SCENE:
+    {
+        int index = _settingsManager.findScene(command.text);
+        if (index < 0)
+            return false;
+        settings.scenes.erase(settings.scenes.begin() + index);
+        reconfigure = true;
+        return false;
+    }
+
+    case CMD_SET_HOSTNAME:
+        settings.mDNSName = command.text;
+        return false;
+
+    case CMD_PERSIST:
+        return false;
+    }
+    return false;
+}
+
+bool StateReducer::setChannel(ChannelSetting &channel, const Command &command)
+{
+    bool changed = channel.state != command.state;
+    channel.state = command.state;
+    if (command.value >= 0 && channel.brightness != command.value)
+    {
+        channel.brightness = constrain(command.value, 0, 100);
+        changed = true;
+    }
+    return changed;
+}
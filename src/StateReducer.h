@@ -0,0 +1,51 @@
+#ifndef STATE_REDUCER_H
+#define STATE_REDUCER_H
+
+#include <Arduino.h>
+#include "CommandQueue.h"
+#include "SettingsManager.h"
+#include "LedController.h"
+#include "Scheduler.h"
+#include "TimeManager.h"
+#include "IrManager.h"
+#include "WifiConnector.h"
+
+#define PERSIST_DELAY_MS 1000 // Coalesce saves until inputs have been quiet this long
+
+/**
+ * The only place that mutates DeviceSettings in response to inputs. Each
+ * tick drains the CommandQueue, applies every command to the settings,
+ * updates the LEDs at most once and schedules at most one deferred save.
+ */
+class StateReducer
+{
+public:
+    StateReducer(CommandQueue &queue, SettingsManager &settingsMgr, LedController &ledCtrl,
+                 Scheduler &scheduler, TimeManager &timeMgr, IrManager &irMgr, WiFiConnector &wifi);
+
+    /**
+     * @brief Applies all queued commands and runs a due save. Call once per loop pass.
+     */
+    void process();
+
+    /**
+     * @brief Writes pending changes now, e.g. before a restart.
+     */
+    void flush();
+
+private:
+    CommandQueue &_queue;
+    SettingsManager &_settingsManager;
+    LedController &_ledController;
+    Scheduler &_scheduler;
+    TimeManager &_timeManager;
+    IrManager &_irManager;
+    WiFiConnector &_wifiConnector;
+    bool _dirty;
+    unsigned long _dirtySince;
+
+    bool apply(const Command &command, DeviceSettings &settings, bool &reconfigure);
+    static bool setChannel(ChannelSetting &channel, const Command &command);
+};
+
+#endif // STATE_REDUCER_H
@@ -0,0 +1,58 @@
+#include "TaskRunner.h"
+#include <ArduinoLog.h>
+
+TaskRunner::TaskRunner() : _taskCount(0) {}
+
+bool TaskRunner::add(const char *name, TaskFunction function, uint32_t periodMs, uint32_t budgetUs)
+{
+    if (_taskCount >= TASK_RUNNER_MAX_TASKS)
+    {
+        Log.errorln("[Tasks] Task table full, cannot add %s.", name);
+        return false;
+    }
+    Task &task = _tasks[_taskCount++];
+    task.name = name;
+    task.function = function;
+    task.periodMs = periodMs;
+    task.budgetUs = budgetUs;
+    // Stagger first runs so periodic tasks do not all fire on the same pass
+    task.lastRun = millis() - (periodMs * _taskCount) / TASK_RUNNER_MAX_TASKS;
+    task.runs = 0;
+    task.overruns = 0;
+    task.maxUs = 0;
+    task.totalUs = 0;
+    return true;
+}
+
+void TaskRunner::run()
+{
+    for (size_t i = 0; i < _taskCount; i++)
+    {
+        Task &task = _tasks[i];
+        unsigned long now = millis();
+        if (task.periodMs > 0 && now - task.lastRun < task.periodMs)
+            continue;
+        task.lastRun = now;
+
+        uint32_t start = micros();
+        task.function();
+        uint32_t elapsed = micros() - start;
+
+        task.runs++;
+        task.totalUs += elapsed;
+        if (elapsed > task.maxUs)
+            task.maxUs = elapsed;
+        if (elapsed > task.budgetUs)
+            task.overruns++;
+    }
+}
+
+size_t TaskRunner::getTaskCount() const
+{
+    return _taskCount;
+}
+
+const TaskRunner::Task &TaskRunner::getTask(size_t index) const
+{
+    return _tasks[index];
+}
@@ -0,0 +1,50 @@
+#ifndef TASK_RUNNER_H
+#define TASK_RUNNER_H
+
+#include <Arduino.h>
+
+#define TASK_RUNNER_MAX_TASKS 16
+
+/**
+ * Cooperative runner for the main loop. Each subsystem registers a period
+ * (0 = every pass) and a time budget; run() calls whatever is due and keeps
+ * run counts, timing and budget overruns per task.
+ */
+class TaskRunner
+{
+public:
+    typedef void (*TaskFunction)();
+
+    struct Task
+    {
+        const char *name;
+        TaskFunction function;
+        uint32_t periodMs;
+        uint32_t budgetUs;
+        unsigned long lastRun;
+        uint32_t runs;
+        uint32_t overruns;
+        uint32_t maxUs;
+        uint64_t totalUs;
+    };
+
+    TaskRunner();
+
+    /**
+     * @brief Registers a task.
+     * @param name Static name used in stats.
+     * @param periodMs Minimum time between runs, 0 to run on every pass.
+     * @param budgetUs Runs longer than this are counted as overruns.
+     * @return false if the task table is full.
+     */
+    bool add(const char *name, TaskFunction function, uint32_t periodMs, uint32_t budgetUs);
+    void run();
+    size_t getTaskCount() const;
+    const Task &getTask(size_t index) const;
+
+private:
+    Task _tasks[TASK_RUNNER_MAX_TASKS];
+    size_t _taskCount;
+};
+
+#endif // TASK_RUNNER_H
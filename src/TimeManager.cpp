@@ -1,48 +1,273 @@
 #include "TimeManager.h"
+#include <ESP8266WiFi.h>
 #include <ArduinoLog.h>
+#include <lwip/dns.h>
+#include <time.h>
 
-// Initialize with a default offset of 0. It will be updated from settings.
-TimeManager::TimeManager() : _timeClient(_ntpUDP, "pool.ntp.org", 0, NTP_UPDATE_INTERVAL)
+#define NTP_PACKET_SIZE 48
+#define NTP_UNIX_OFFSET 2208988800UL // Seconds from 1900 (NTP era 0) to 1970
+#define NTP_REBASE_MS 3600000UL      // Fold elapsed millis() into the base before it can wrap
+
+static uint32_t readBigEndian32(const uint8_t *data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+TimeManager::TimeManager()
+    : _state(NTP_IDLE), _stateSince(0), _nextSync(0), _retryDelay(NTP_RETRY_MIN_MS), _dnsDone(false),
+      _requestCookie(0), _baseUtcMs(0), _baseMillis(0), _driftPpm(0), _timeValid(false), _ntpSynced(false),
+      _lastSyncUtcMs(0), _cacheMinuteStart(-1), _cachedHour(0), _cachedMinute(0)
 {
 }
 
 void TimeManager::begin()
 {
-    _timeClient.begin();
-    Log.infoln("[TimeMgr] Initialized for IST (UTC+5:30).");
+    _udp.begin(NTP_LOCAL_PORT);
+    _nextSync = millis();
+    Log.infoln("[TimeMgr] Initialized, syncing from %s.", NTP_SERVER);
 }
 
 void TimeManager::update()
 {
-    if (_timeClient.update())
+    // Keep the millis() delta short so the clock survives its 49 day wrap
+    if (millis() - _baseMillis > NTP_REBASE_MS)
     {
-        Log.infoln("[TimeMgr] NTP time updated: %s", getFormattedTime().c_str());
+        setClock(nowUtcMs());
+    }
+
+    switch (_state)
+    {
+    case NTP_IDLE:
+        if ((long)(millis() - _nextSync) >= 0)
+        {
+            startSync();
+        }
+        break;
+
+    case NTP_RESOLVING:
+        if (_dnsDone)
+        {
+            if (_serverIp.isSet())
+                sendRequest();
+            else
+                failSync("DNS lookup failed");
+        }
+        else if (millis() - _stateSince > NTP_TIMEOUT_MS)
+        {
+            failSync("DNS timeout");
+        }
+        break;
+
+    case NTP_WAITING:
+        readResponse();
+        break;
     }
 }
 
-void TimeManager::setTimezone(long gmtOffsetSeconds)
+void TimeManager::startSync()
 {
-    if (_current_gmtOffsetSeconds != gmtOffsetSeconds)
+    ip_addr_t addr;
+    _dnsDone = false;
+    err_t err = dns_gethostbyname(NTP_SERVER, &addr, &TimeManager::dnsFound, this);
+    if (err == ERR_OK)
     {
-        Log.infoln("[TimeMgr] Timezone offset changed to %ld seconds. Updating NTP client.", gmtOffsetSeconds);
-        _current_gmtOffsetSeconds = gmtOffsetSeconds;
-        _timeClient.setTimeOffset(gmtOffsetSeconds);
-        // Force an update to apply the new timezone immediately
-        _timeClient.forceUpdate();
+        _serverIp = IPAddress(addr);
+        sendRequest();
+    }
+    else if (err == ERR_INPROGRESS)
+    {
+        _state = NTP_RESOLVING;
+        _stateSince = millis();
+    }
+    else
+    {
+        failSync("DNS request rejected");
     }
 }
 
+void TimeManager::dnsFound(const char *name, const ip_addr_t *ip, void *arg)
+{
+    // Runs from the lwIP callback; update() picks the result up on its next pass
+    TimeManager *self = static_cast<TimeManager *>(arg);
+    self->_serverIp = ip ? IPAddress(ip) : IPAddress();
+    self->_dnsDone = true;
+}
+
+void TimeManager::sendRequest()
+{
+    // Drop anything left over from an earlier, timed out request
+    while (_udp.parsePacket() > 0)
+    {
+    }
+
+    uint8_t packet[NTP_PACKET_SIZE];
+    memset(packet, 0, sizeof(packet));
+    packet[0] = 0x23; // LI 0, version 4, mode 3 (client)
+    // The server echoes our transmit timestamp as its originate timestamp; use it to match the reply
+    _requestCookie = micros() ^ RANDOM_REG32;
+    packet[40] = _requestCookie >> 24;
+    packet[41] = _requestCookie >> 16;
+    packet[42] = _requestCookie >> 8;
+    packet[43] = _requestCookie;
+
+    if (!_udp.beginPacket(_serverIp, 123) || _udp.write(packet, sizeof(packet)) != sizeof(packet) || !_udp.endPacket())
+    {
+        failSync("send failed");
+        return;
+    }
+    _state = NTP_WAITING;
+    _stateSince = millis();
+}
+
+void TimeManager::readResponse()
+{
+    if (_udp.parsePacket() < NTP_PACKET_SIZE)
+    {
+        if (millis() - _stateSince > NTP_TIMEOUT_MS)
+        {
+            failSync("no reply");
+        }
+        return;
+    }
+    unsigned long arrival = millis();
+    uint8_t packet[NTP_PACKET_SIZE];
+    _udp.read(packet, sizeof(packet));
+
+    uint8_t leap = packet[0] >> 6;
+    uint8_t mode = packet[0] & 0x07;
+    uint8_t stratum = packet[1];
+    if (mode != 4 || stratum == 0 || leap == 3 || readBigEndian32(&packet[24]) != _requestCookie)
+    {
+        // Kiss-o'-death, unsynchronized server or a stray packet; keep waiting until the timeout
+        return;
+    }
+
+    // Server receive (T2) and transmit (T3) timestamps, seconds since 1900 plus 32 bit fraction
+    uint64_t received = (uint64_t)(readBigEndian32(&packet[32]) - NTP_UNIX_OFFSET) * 1000 + (((uint64_t)readBigEndian32(&packet[36]) * 1000) >> 32);
+    uint64_t transmitted = (uint64_t)(readBigEndian32(&packet[40]) - NTP_UNIX_OFFSET) * 1000 + (((uint64_t)readBigEndian32(&packet[44]) * 1000) >> 32);
+    uint32_t roundTrip = arrival - _stateSince;
+    uint32_t serverHold = transmitted > received ? transmitted - received : 0;
+    uint32_t networkDelay = roundTrip > serverHold ? roundTrip - serverHold : 0;
+    uint64_t serverNow = transmitted + networkDelay / 2 + (millis() - arrival);
+
+    int64_t error = (int64_t)(serverNow - nowUtcMs());
+    if (_ntpSynced)
+    {
+        // The residual error over the last interval is what the current drift estimate missed
+        int64_t interval = (int64_t)(serverNow - _lastSyncUtcMs);
+        if (interval > 600000)
+        {
+            int32_t correction = (int32_t)(error * 1000000 / interval);
+            _driftPpm = constrain(_driftPpm + correction / 2, -NTP_MAX_DRIFT_PPM, NTP_MAX_DRIFT_PPM);
+        }
+    }
+    setClock(serverNow);
+    _lastSyncUtcMs = serverNow;
+    _ntpSynced = true;
+    _timeValid = true;
+    _state = NTP_IDLE;
+    _retryDelay = NTP_RETRY_MIN_MS;
+    _nextSync = millis() + NTP_UPDATE_INTERVAL;
+    Log.infoln("[TimeMgr] NTP time updated: %s (step %l ms, delay %u ms, drift %l ppm)",
+               getFormattedTime().c_str(), (long)error, (unsigned long)networkDelay, (long)_driftPpm);
+}
+
+void TimeManager::failSync(const char *reason)
+{
+    Log.warningln("[TimeMgr] NTP sync failed: %s. Retrying in %u s.", reason, (unsigned long)(_retryDelay / 1000));
+    _state = NTP_IDLE;
+    _nextSync = millis() + _retryDelay;
+    _retryDelay = min(_retryDelay * 2, (unsigned long)NTP_RETRY_MAX_MS);
+}
+
+uint64_t TimeManager::nowUtcMs()
+{
+    unsigned long elapsed = millis() - _baseMillis;
+    return _baseUtcMs + elapsed + (int64_t)elapsed * _driftPpm / 1000000;
+}
+
+void TimeManager::setClock(uint64_t utcMs)
+{
+    _baseUtcMs = utcMs;
+    _baseMillis = millis();
+    _cacheMinuteStart = -1;
+}
+
+void TimeManager::setTimezone(const String &posixTz, long gmtOffsetSeconds)
+{
+    String timezone = posixTz;
+    if (timezone.length() == 0)
+    {
+        // POSIX offsets count west of UTC, the opposite sign of gmtOffsetSeconds
+        long offset = labs(gmtOffsetSeconds);
+        char rule[24];
+        snprintf(rule, sizeof(rule), "STD%c%02ld:%02ld:%02ld", gmtOffsetSeconds > 0 ? '-' : '+',
+                 offset / 3600, offset / 60 % 60, offset % 60);
+        timezone = rule;
+    }
+    if (timezone != _timezone)
+    {
+        Log.infoln("[TimeMgr] Timezone changed to %s.", timezone.c_str());
+        _timezone = timezone;
+        setenv("TZ", _timezone.c_str(), 1);
+        tzset();
+        _cacheMinuteStart = -1;
+    }
+}
+
+void TimeManager::refreshLocalCache()
+{
+    // Offsets (including DST) change on minute boundaries, so one conversion per minute suffices
+    time_t now = nowUtcMs() / 1000;
+    if (_cacheMinuteStart >= 0 && now >= _cacheMinuteStart && now < _cacheMinuteStart + 60)
+        return;
+    struct tm local;
+    localtime_r(&now, &local);
+    _cacheMinuteStart = now - local.tm_sec;
+    _cachedHour = local.tm_hour;
+    _cachedMinute = local.tm_min;
+}
+
 String TimeManager::getFormattedTime()
 {
-    return _timeClient.getFormattedTime();
+    time_t now = nowUtcMs() / 1000;
+    struct tm local;
+    localtime_r(&now, &local);
+    char buffer[9];
+    snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", local.tm_hour, local.tm_min, local.tm_sec);
+    return String(buffer);
 }
 
 int TimeManager::getHours()
 {
-    return _timeClient.getHours();
+    refreshLocalCache();
+    return _cachedHour;
 }
 
 int TimeManager::getMinutes()
 {
-    return _timeClient.getMinutes();
-}
\ No newline at end of file
+    refreshLocalCache();
+    return _cachedMinute;
+}
+
+bool TimeManager::isTimeValid()
+{
+    return _timeValid;
+}
+
+unsigned long TimeManager::getEpochTime()
+{
+    return nowUtcMs() / 1000;
+}
+
+void TimeManager::setEpochTime(unsigned long utcSeconds)
+{
+    // Seeds the clock (e.g. from RTC memory after a reset) until the next NTP sync
+    setClock((uint64_t)utcSeconds * 1000);
+    _timeValid = true;
+}
+
+int32_t TimeManager::getDriftPpm()
+{
+    return _driftPpm;
+}
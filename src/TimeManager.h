@@ -1,26 +1,88 @@
 #ifndef TIME_MANAGER_H
 #define TIME_MANAGER_H
 
-#include <NTPClient.h>
+#include <Arduino.h>
 #include <WiFiUdp.h>
+#include <lwip/ip_addr.h>
 
+#define NTP_SERVER "pool.ntp.org"
+#define NTP_LOCAL_PORT 2390
 #define NTP_UPDATE_INTERVAL 3600000 // 1 hour in ms
+#define NTP_TIMEOUT_MS 2000         // Give up on a request (DNS or UDP) after this long
+#define NTP_RETRY_MIN_MS 5000       // First retry after a failed sync, doubling up to NTP_RETRY_MAX_MS
+#define NTP_RETRY_MAX_MS 300000
+#define NTP_MAX_DRIFT_PPM 500       // Clamp for the estimated oscillator error
 
+/**
+ * Local clock kept from SNTP without ever blocking the loop. update() steps
+ * a small state machine (async DNS, request, poll for the reply); between
+ * syncs time runs from millis() corrected by the drift measured across
+ * previous syncs. Local time follows a POSIX TZ rule (with DST) or a fixed
+ * offset, and hour/minute lookups are cached per minute for the scheduler.
+ */
 class TimeManager
 {
 public:
     TimeManager();
     void begin();
+
+    /**
+     * @brief Advances the SNTP state machine. Cheap when nothing is due; call often while WiFi is up.
+     */
     void update();
-    void setTimezone(long gmtOffsetSeconds);
+
+    /**
+     * @brief Sets local time rules.
+     * @param posixTz POSIX TZ string, e.g. "CET-1CEST,M3.5.0,M10.5.0/3". Empty uses the fixed offset.
+     * @param gmtOffsetSeconds Fixed offset east of UTC, used when posixTz is empty.
+     */
+    void setTimezone(const String &posixTz, long gmtOffsetSeconds);
     String getFormattedTime();
     int getHours();
     int getMinutes();
+    bool isTimeValid();
+    unsigned long getEpochTime(); // UTC seconds
+    void setEpochTime(unsigned long utcSeconds);
+    int32_t getDriftPpm();
 
 private:
-    WiFiUDP _ntpUDP;
-    NTPClient _timeClient;
-    long _current_gmtOffsetSeconds;
+    enum NtpState
+    {
+        NTP_IDLE,
+        NTP_RESOLVING,
+        NTP_WAITING
+    };
+
+    WiFiUDP _udp;
+    NtpState _state;
+    unsigned long _stateSince;
+    unsigned long _nextSync;
+    unsigned long _retryDelay;
+    volatile bool _dnsDone;
+    IPAddress _serverIp;
+    uint32_t _requestCookie;
+
+    // Clock: UTC ms at _baseMillis, advanced by elapsed millis() plus drift correction
+    uint64_t _baseUtcMs;
+    unsigned long _baseMillis;
+    int32_t _driftPpm;
+    bool _timeValid;
+    bool _ntpSynced;
+    uint64_t _lastSyncUtcMs;
+
+    String _timezone;
+    time_t _cacheMinuteStart;
+    int _cachedHour;
+    int _cachedMinute;
+
+    uint64_t nowUtcMs();
+    void setClock(uint64_t utcMs);
+    void startSync();
+    void sendRequest();
+    void readResponse();
+    void failSync(const char *reason);
+    void refreshLocalCache();
+    static void dnsFound(const char *name, const ip_addr_t *ip, void *arg);
 };
 
-#endif
\ No newline at end of file
+#endif
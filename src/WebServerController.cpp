@@ -1,13 +1,15 @@
 #include "WebServerController.h"
 #include "LittleFS.h"
-#include <ESP8266mDNS.h>
 #include <ArduinoJson.h>
 #include <ArduinoLog.h>
+#include "Profiler.h"
 
-#define JSON_BUFFER_SIZE 2048 // more the channels greater the size, 1024 per 4 channels approx
+#define JSON_BUFFER_SIZE 3072 // more the channels greater the size, 1024 per 4 channels approx, ~100 per scene
+#define SETTINGS_UPLOAD_TMP "/settings.json.tmp"
+#define SETTINGS_UPLOAD_MAX 16384 // Bytes on disk; whitespace doesn't count against the parse buffer, so this is looser
 
-WebServerController::WebServerController(int port, WebSocketsServer &ws, SettingsManager &settingsMgr, LedController &ledCtrl, Scheduler &scheduler, TimeManager &timeMgr)
-    : _server(port), _ws(ws), _settingsManager(settingsMgr), _ledController(ledCtrl), _scheduler(scheduler), _timeManager(timeMgr) {}
+WebServerController::WebServerController(int port, WebSocketsServer &ws, SettingsManager &settingsMgr, LedController &ledCtrl, Scheduler &scheduler, TimeManager &timeMgr, MDNSManager &mdnsMgr, CrashLog &crashLog, IrManager &irMgr, TaskRunner &taskRunner, CommandQueue &commands, OTAUpdater &otaUpdater)
+    : _server(port), _ws(ws), _settingsManager(settingsMgr), _ledController(ledCtrl), _scheduler(scheduler), _timeManager(timeMgr), _mdnsManager(mdnsMgr), _crashLog(crashLog), _irManager(irMgr), _taskRunner(taskRunner), _commands(commands), _otaUpdater(otaUpdater) {}
 
 void WebServerController::begin()
 {
@@ -23,15 +25,31 @@ void WebServerController::begin()
     _server.on("/settings.json", HTTP_GET, [this]() { 
         this->handleDownloadSettings(); 
     });
+    _server.on("/logtokens.json", HTTP_GET, [this]()
+               { this->serveFile("/logtokens.json"); });
+    _server.on("/crashlog", HTTP_GET, [this]()
+               { this->handleCrashLog(); });
+    _server.on("/tasks", HTTP_GET, [this]()
+               { this->handleTasks(); });
+    _server.on("/profile", HTTP_GET, [this]()
+               { this->handleProfile(); });
+    _server.on("/ir/learn", HTTP_POST, [this]()
+               { this->handleIrLearnStart(); });
+    _server.on("/ir/learn", HTTP_GET, [this]()
+               { this->handleIrLearnStatus(); });
+    _server.on("/scene", HTTP_POST, [this]()
+               { this->handleScene(); });
+    _server.on("/ir/learn/cancel", HTTP_POST, [this]()
+               {
+        _irManager.cancelLearning();
+        _server.send(200, "application/json", "{\"success\":true}"); });
+
+    _server.on("/update", HTTP_POST, [this]()
+               { this->handleUpdate(); }, [this]()
+               { this->handleUpdateUpload(); });
 
     _server.on("/upload", HTTP_POST, [this]() { 
-        if (_uploadFilename == "settings.json") { 
-            _server.send(200, "text/plain", "Settings uploaded. Restarting...");
-            ESP.restart(); 
-        } else { 
-            _server.send(200, "text/plain", "File uploaded successfully."); 
-        }
-        _uploadFilename = ""; 
+        this->handleUpload(); 
     }, [this]() { 
         this->handleFileUpload(); 
     });
@@ -87,95 +105,194 @@ void WebServerController::handleSettings()
         return;
     }
 
-    DeviceSettings &settings = _settingsManager.getSettings();
+    // Edit a copy; the reducer swaps it in, so it stays the only writer of the live settings
+    DeviceSettings settings = _settingsManager.getSettings();
 
     // Update scheduler settings from JSON
-    settings.gmtOffsetSeconds = doc["gmt_offset"] | 19800; // Use default if missing
-    settings.irCodeBrightnessUp = doc["irCodeBrightnessUp"].as<String>();
-    settings.irCodeBrightnessDown = doc["irCodeBrightnessDown"].as<String>();
+    settings.gmtOffsetSeconds = doc["gmt_offset"] | settings.gmtOffsetSeconds; // Missing fields keep their value
+    settings.timezone = doc["timezone"] | settings.timezone;
+    settings.groupId = doc["groupId"] | settings.groupId;
+    // MQTT: like WiFi passwords, an empty password keeps the stored one
+    if (doc.containsKey("mqttHost"))
+    {
+        settings.mqttHost = doc["mqttHost"] | "";
+        settings.mqttPort = doc["mqttPort"] | 1883;
+        settings.mqttUser = doc["mqttUser"] | "";
+        settings.mqttTopic = doc["mqttTopic"] | "";
+        String mqttPassword = doc["mqttPassword"] | "";
+        if (mqttPassword.length() > 0 || settings.mqttUser.length() == 0)
+            settings.mqttPassword = mqttPassword;
+    }
+    settings.dmxProtocol = doc["dmxProtocol"] | settings.dmxProtocol;
+    settings.dmxUniverse = doc["dmxUniverse"] | settings.dmxUniverse;
+    settings.dmxStartSlot = constrain((int)(doc["dmxStartSlot"] | settings.dmxStartSlot), 1, 512);
+    settings.pwmBackend = doc["pwmBackend"] | settings.pwmBackend;
+    settings.pwmFrequency = doc["pwmFrequency"] | settings.pwmFrequency;
+    settings.pwmStagger = doc["pwmStagger"] | settings.pwmStagger;
+    settings.pca9685Address = doc["pca9685Address"] | settings.pca9685Address;
+    settings.irCodeBrightnessUp = SettingsManager::parseIrCode(doc["irCodeBrightnessUp"] | "");
+    settings.irCodeBrightnessDown = SettingsManager::parseIrCode(doc["irCodeBrightnessDown"] | "");
+
+    // Networks: an empty or missing password keeps the stored one, /status never returns them
+    if (doc["networks"].is<JsonArray>())
+    {
+        std::vector<WifiNetwork> networks;
+        for (JsonObject networkJson : doc["networks"].as<JsonArray>())
+        {
+            WifiNetwork network;
+            network.ssid = networkJson["ssid"].as<String>();
+            network.password = networkJson["password"] | "";
+            if (network.ssid.length() == 0)
+                continue;
+            if (network.password.length() == 0)
+            {
+                for (const auto &existing : settings.networks)
+                {
+                    if (existing.ssid == network.ssid)
+                        network.password = existing.password;
+                }
+            }
+            networks.push_back(network);
+        }
+        settings.networks = networks;
+    }
 
     String newMDNSName = doc["mDNSName"].as<String>();
+    bool renamePending = false;
 
     if (settings.mDNSName != newMDNSName)
     {
-        // Check if the new mDNS name is already in use
-        if (MDNS.queryService(newMDNSName, "tcp") > 0)
+        // Probing runs in the background; the name is persisted once it is confirmed unique
+        if (!_mdnsManager.rename(newMDNSName))
         {
-            Log.infoln("[Web] mDNS name already in use.");
-            _server.send(400, "application/json", "{\"error\":\"mDNS name already in use\"}");
+            _server.send(400, "application/json", "{\"error\":\"mDNS rename rejected\"}");
             return;
         }
-
-        Log.infoln("[Web] mDNS name changed. Restarting...");
-        settings.mDNSName = newMDNSName;
-        _settingsManager.saveSettings();
-        ESP.restart();
+        Log.infoln("[Web] mDNS name change to %s requested.", newMDNSName.c_str());
+        renamePending = true;
     }
     // Update channel settings from JSON
     JsonArray channelsArray = doc["channels"].as<JsonArray>();
-    const char *safePins[] = {"D1", "D2", "D3", "D5", "D6", "D7"};
-    const int numSafePins = sizeof(safePins) / sizeof(safePins[0]);
 
     settings.channels.clear(); // Clear old channels before adding new ones
     for (JsonObject channelJson : channelsArray)
     {
         ChannelSetting ch;
-        String pin = channelJson["pin"].as<String>();
+        ch.pin = channelJson["pin"].as<String>();
+        ch.channelName = channelJson["channelName"].as<String>();
+        ch.irCode = SettingsManager::parseIrCode(channelJson["irCode"] | "");
+        ch.state = channelJson["state"];
+        ch.brightness = channelJson["brightness"];
+        ch.scheduleEnabled = channelJson["schedulerEnabled"];
+        ch.startTime = channelJson["scheduler_start"].as<String>();
+        ch.endTime = channelJson["scheduler_end"].as<String>();
+        ch.scheduledBrightness = channelJson["scheduler_brightness"];
+        settings.channels.push_back(ch);
+    }
+    dropUnsafePins(settings);
+
+    // Apply the new settings
+    applySettings(new DeviceSettings(std::move(settings)), true);
+    if (renamePending)
+        _server.send(202, "application/json", "{\"success\":true,\"mDNS\":\"probing\"}");
+    else
+        _server.send(200, "application/json", "{\"success\":true}");
+}
+
+void WebServerController::dropUnsafePins(DeviceSettings &settings)
+{
+    const char *safePins[] = {"D1", "D2", "D3", "D5", "D6", "D7"};
+    const int numSafePins = sizeof(safePins) / sizeof(safePins[0]);
+    // With an expander D1/D2 carry I2C, and its channels P0-P15 become available
+    bool expander = settings.pca9685Address != 0;
+
+    for (auto &ch : settings.channels)
+    {
+        const String &pin = ch.pin;
         bool isSafe = false;
         for (int i = 0; i < numSafePins; i++)
         {
             if (pin == safePins[i])
             {
-                isSafe = true;
+                isSafe = !(expander && (pin == "D1" || pin == "D2"));
                 break;
             }
         }
-
-        if (isSafe)
+        if (expander && LedController::pinNameToNumber(pin) >= LED_OUTPUT_EXPANDER)
+        {
+            isSafe = true;
+        }
+        // D0 has no hardware PWM; the software engine can drive it
+        if (pin == "D0" && settings.pwmBackend == "soft")
         {
-            ch.pin = pin;
+            isSafe = true;
         }
-        else
+
+        if (!isSafe && pin.length() > 0)
         {
             Log.warningln("[Web] Invalid pin specified: %s. Ignoring.", pin.c_str());
             ch.pin = ""; // Invalid pin, assign empty string
         }
-
-        ch.channelName = channelJson["channelName"].as<String>();
-        ch.irCode = channelJson["irCode"].as<String>();
-        ch.state = channelJson["state"];
-        ch.brightness = channelJson["brightness"];
-        ch.scheduleEnabled = channelJson["schedulerEnabled"];
-        ch.startTime = channelJson["scheduler_start"].as<String>();
-        ch.endTime = channelJson["scheduler_end"].as<String>();
-        ch.scheduledBrightness = channelJson["scheduler_brightness"];
-        settings.channels.push_back(ch);
     }
+}
 
-    // Apply the new settings
-    _ledController.update(settings); // Note: LedController needs refactoring for multi-channel
-    _timeManager.setTimezone(settings.gmtOffsetSeconds);
-    _scheduler.updateSchedule(settings);
-    _settingsManager.saveSettings();
-    _server.send(200, "application/json", "{\"success\":true}");
+void WebServerController::applySettings(DeviceSettings *settings, bool persist)
+{
+    // The reducer swaps the settings in and re-applies LEDs, timezone, schedule and IR bindings once on its next tick
+    Command command;
+    command.type = CMD_SETTINGS_CHANGED;
+    command.settings = settings;
+    command.persist = persist;
+    _commands.push(command);
 }
 
 void WebServerController::handleStatus()
 {
-    DeviceSettings &settings = _settingsManager.getSettings();
+    PROFILE_ZONE("web.status");
+    const DeviceSettings &settings = _settingsManager.getSettings();
     DynamicJsonDocument doc(JSON_BUFFER_SIZE); // Adjust size as needed
 
     doc["gmt_offset"] = settings.gmtOffsetSeconds;
+    doc["timezone"] = settings.timezone;
+    doc["groupId"] = settings.groupId;
+    doc["mqttHost"] = settings.mqttHost;
+    doc["mqttPort"] = settings.mqttPort;
+    doc["mqttUser"] = settings.mqttUser;
+    doc["mqttTopic"] = settings.mqttTopic;
+    doc["dmxProtocol"] = settings.dmxProtocol;
+    doc["dmxUniverse"] = settings.dmxUniverse;
+    doc["dmxStartSlot"] = settings.dmxStartSlot;
+    doc["pwmBackend"] = settings.pwmBackend;
+    doc["pwmFrequency"] = settings.pwmFrequency;
+    doc["pwmStagger"] = settings.pwmStagger;
+    doc["pca9685Address"] = settings.pca9685Address;
     doc["mDNSName"] = settings.mDNSName;
-    doc["irCodeBrightnessUp"] = settings.irCodeBrightnessUp;
-    doc["irCodeBrightnessDown"] = settings.irCodeBrightnessDown;
+    doc["irCodeBrightnessUp"] = SettingsManager::formatIrCode(settings.irCodeBrightnessUp);
+    doc["irCodeBrightnessDown"] = SettingsManager::formatIrCode(settings.irCodeBrightnessDown);
+    doc["wifiSsid"] = WiFi.SSID();
+    doc["wifiRssi"] = WiFi.RSSI();
+
+    JsonArray networks = doc.createNestedArray("networks");
+    for (const auto &network : settings.networks)
+    {
+        networks.createNestedObject()["ssid"] = network.ssid;
+    }
+
+    JsonArray scenes = doc.createNestedArray("scenes");
+    for (const auto &scene : settings.scenes)
+    {
+        JsonObject sceneJson = scenes.createNestedObject();
+        sceneJson["name"] = scene.name;
+        sceneJson["irCode"] = SettingsManager::formatIrCode(scene.irCode);
+        sceneJson["time"] = scene.time;
+    }
 
     JsonArray channels = doc.createNestedArray("channels");
     for (const auto &ch_setting : settings.channels)
     {
         JsonObject channel = channels.createNestedObject();
         channel["pin"] = ch_setting.pin;
-        channel["irCode"] = ch_setting.irCode;
+        channel["irCode"] = SettingsManager::formatIrCode(ch_setting.irCode);
         channel["channelName"] = ch_setting.channelName;
         channel["state"] = ch_setting.state;
         channel["brightness"] = ch_setting.brightness;
@@ -206,24 +323,311 @@ void WebServerController::handleNotFound()
 
 void WebServerController::handleDownloadSettings()
 {
+    // Passwords live in /secrets.json, which no route serves
     serveFile("/settings.json");
 }
 
+void WebServerController::handleCrashLog()
+{
+    // Flush staged lines first so the response includes the most recent history
+    _crashLog.spill();
+
+    _server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    _server.send(200, "text/plain", "");
+    _server.sendContent("Current boot: " + _crashLog.getResetSummary() + "\n");
+
+    const char *files[] = {"/crash.log.1", "/crash.log"};
+    char buffer[256];
+    for (const char *path : files)
+    {
+        File file = LittleFS.open(path, "r");
+        if (!file)
+            continue;
+        while (file.available())
+        {
+            size_t count = file.readBytes(buffer, sizeof(buffer));
+            _server.sendContent(buffer, count);
+        }
+        file.close();
+    }
+    _server.sendContent("");
+}
+
+void WebServerController::handleIrLearnStart()
+{
+    DynamicJsonDocument doc(128);
+    if (!_server.hasArg("plain") || deserializeJson(doc, _server.arg("plain")))
+    {
+        _server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        return;
+    }
+
+    // action is "brightnessUp", "brightnessDown", "channel" or "scene" (with a channel or scene index)
+    String action = doc["action"] | "";
+    uint8_t channel = doc["channel"] | 0;
+    uint32_t timeout = doc["timeout"] | 15000;
+    IrActionType type = IR_ACTION_TOGGLE_CHANNEL;
+    if (action == "brightnessUp")
+        type = IR_ACTION_BRIGHTNESS_UP;
+    else if (action == "brightnessDown")
+        type = IR_ACTION_BRIGHTNESS_DOWN;
+    else if (action == "channel" && channel < _settingsManager.getSettings().channels.size())
+        type = IR_ACTION_TOGGLE_CHANNEL;
+    else if (action == "scene" && channel < _settingsManager.getSettings().scenes.size())
+        type = IR_ACTION_RECALL_SCENE;
+    else
+    {
+        _server.send(400, "application/json", "{\"error\":\"Unknown action\"}");
+        return;
+    }
+
+    _irManager.startLearning(type, channel, timeout);
+    _server.send(200, "application/json", "{\"success\":true}");
+}
+
+void WebServerController::handleIrLearnStatus()
+{
+    static const char *states[] = {"idle", "listening", "captured", "bound", "timeout"};
+    DynamicJsonDocument doc(192);
+    IrLearnState state = _irManager.getLearnState();
+    doc["state"] = states[state];
+    if (state == IR_LEARN_CAPTURED || state == IR_LEARN_BOUND)
+    {
+        const IrLearnResult &result = _irManager.getLearnResult();
+        doc["code"] = SettingsManager::formatIrCode(result.code);
+        doc["protocol"] = IrManager::protocolName(result.protocol);
+        doc["bits"] = result.bits;
+        doc["action"] = (int)result.action;
+        doc["channel"] = result.channel;
+    }
+    String json;
+    serializeJson(doc, json);
+    _server.send(200, "application/json", json);
+}
+
+void WebServerController::handleScene()
+{
+    // /scene?name=<name>&action=recall|save|schedule|delete, plus fade=<ms> (recall) or time=HH:MM (schedule)
+    const DeviceSettings &settings = _settingsManager.getSettings();
+    String name = _server.arg("name");
+    String action = _server.hasArg("action") ? _server.arg("action") : "recall";
+    int index = _settingsManager.findScene(name);
+    Command command;
+    command.persist = true;
+
+    if (action == "recall")
+    {
+        if (index < 0)
+        {
+            _server.send(404, "application/json", "{\"error\":\"Unknown scene\"}");
+            return;
+        }
+        command.type = CMD_RECALL_SCENE;
+        command.value = index;
+        command.transitionMs = _server.hasArg("fade") ? _server.arg("fade").toInt() : SCENE_FADE_MS;
+    }
+    else if (action == "save")
+    {
+        if (name.length() == 0 || (index < 0 && settings.scenes.size() >= SCENE_MAX))
+        {
+            _server.send(400, "application/json", "{\"error\":\"Invalid name or too many scenes\"}");
+            return;
+        }
+        command.type = CMD_SAVE_SCENE;
+        command.text = name;
+    }
+    else if (action == "schedule" && index >= 0)
+    {
+        String time = _server.arg("time"); // Empty clears the daily recall
+        int hours = time.substring(0, 2).toInt();
+        int minutes = time.substring(3).toInt();
+        if (time.length() != 0 && (time.length() != 5 || time[2] != ':' || hours > 23 || minutes > 59))
+        {
+            _server.send(400, "application/json", "{\"error\":\"Time must be HH:MM\"}");
+            return;
+        }
+        command.type = CMD_SCHEDULE_SCENE;
+        command.text = name;
+        command.value = time.length() ? hours * 60 + minutes : -1;
+    }
+    else if (action == "delete" && index >= 0)
+    {
+        command.type = CMD_DELETE_SCENE;
+        command.text = name;
+    }
+    else
+    {
+        _server.send(400, "application/json", "{\"error\":\"Unknown action or scene\"}");
+        return;
+    }
+
+    _commands.push(command);
+    _server.send(200, "application/json", "{\"success\":true}");
+}
+
+void WebServerController::handleTasks()
+{
+    DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+    JsonArray tasks = doc.createNestedArray("tasks");
+    for (size_t i = 0; i < _taskRunner.getTaskCount(); i++)
+    {
+        const TaskRunner::Task &task = _taskRunner.getTask(i);
+        JsonObject entry = tasks.createNestedObject();
+        entry["name"] = task.name;
+        entry["periodMs"] = task.periodMs;
+        entry["budgetUs"] = task.budgetUs;
+        entry["runs"] = task.runs;
+        entry["overruns"] = task.overruns;
+        entry["avgUs"] = task.runs ? (uint32_t)(task.totalUs / task.runs) : 0;
+        entry["maxUs"] = task.maxUs;
+    }
+    String json;
+    serializeJson(doc, json);
+    _server.send(200, "application/json", json);
+}
+
+void WebServerController::handleProfile()
+{
+    SoftPwmBackend *softPwm = _ledController.getSoftPwm();
+    if (_server.hasArg("reset"))
+    {
+        Profiler::reset();
+        if (softPwm)
+            softPwm->resetStats();
+    }
+    DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+    uint32_t ticksPerUs = Profiler::ticksPerMicrosecond();
+    doc["ticksPerUs"] = ticksPerUs;
+    // pNN values are histogram bucket upper bounds, at most this many percent above the true value
+    doc["percentileResolutionPct"] = PROFILER_RESOLUTION_PCT;
+    JsonArray zones = doc.createNestedArray("zones");
+    for (size_t i = 0; i < Profiler::getZoneCount(); i++)
+    {
+        const Profiler::Zone &zone = Profiler::getZone(i);
+        JsonObject entry = zones.createNestedObject();
+        entry["name"] = zone.name;
+        entry["count"] = zone.count;
+        if (zone.count == 0)
+        {
+            continue;
+        }
+        entry["minCycles"] = zone.minTicks;
+        entry["avgCycles"] = (uint32_t)(zone.totalTicks / zone.count);
+        entry["maxCycles"] = zone.maxTicks;
+        entry["p50Cycles"] = Profiler::percentile(zone, 0.50f);
+        entry["p90Cycles"] = Profiler::percentile(zone, 0.90f);
+        entry["p99Cycles"] = Profiler::percentile(zone, 0.99f);
+        entry["avgUs"] = (uint32_t)(zone.totalTicks / zone.count / ticksPerUs);
+        entry["maxUs"] = zone.maxTicks / ticksPerUs;
+    }
+    // The PWM interrupt can't use profiler zones (they live in flash), it keeps its own counters
+    if (softPwm)
+    {
+        JsonObject isr = doc.createNestedObject("softPwm");
+        isr["isrs"] = softPwm->getIsrCount();
+        isr["eventsPerPeriod"] = softPwm->getEventCount();
+        isr["avgCycles"] = softPwm->getIsrAvgCycles();
+        isr["maxCycles"] = softPwm->getIsrMaxCycles();
+        isr["maxUs"] = softPwm->getIsrMaxCycles() / ticksPerUs;
+    }
+    String json;
+    serializeJson(doc, json);
+    _server.send(200, "application/json", json);
+}
+
 void WebServerController::handleFileUpload() {
     HTTPUpload& upload = _server.upload();
     if (upload.status == UPLOAD_FILE_START) {
         _uploadFilename = upload.filename;
-        String filename_with_path = "/" + _uploadFilename;
+        _uploadSize = 0;
+        _uploadValid = true;
+        // Settings are staged in a temp file and only swapped in once validated
+        String filename_with_path = _uploadFilename == "settings.json" ? SETTINGS_UPLOAD_TMP : "/" + _uploadFilename;
         fsUploadFile = LittleFS.open(filename_with_path, "w");
     } else if (upload.status == UPLOAD_FILE_WRITE) {
-        if (fsUploadFile) {
+        if (_uploadFilename == "settings.json" && _uploadValid) {
+            // Cheap checks while streaming: must look like a JSON object of sane size.
+            // Whether it fits the parse buffer is up to readSettingsFile().
+            if (_uploadSize == 0 && upload.currentSize > 0 && upload.buf[0] != '{') {
+                Log.warningln("[Web] Uploaded settings do not start with '{'.");
+                _uploadValid = false;
+            }
+            if (_uploadSize + upload.currentSize > SETTINGS_UPLOAD_MAX) {
+                Log.warningln("[Web] Uploaded settings exceed %d bytes.", SETTINGS_UPLOAD_MAX);
+                _uploadValid = false;
+            }
+        }
+        if (fsUploadFile && _uploadValid) {
             fsUploadFile.write(upload.buf, upload.currentSize);
         }
+        _uploadSize += upload.currentSize;
     } else if (upload.status == UPLOAD_FILE_END) {
         if (fsUploadFile) {
             fsUploadFile.close();
         }
+    } else if (upload.status == UPLOAD_FILE_ABORTED) {
+        if (fsUploadFile) {
+            fsUploadFile.close();
+        }
+        _uploadValid = false;
+    }
+}
+
+void WebServerController::handleUpdateUpload()
+{
+    // POST /update?type=firmware|filesystem&md5=<hex of the uncompressed image>, body is a multipart file
+    HTTPUpload &upload = _server.upload();
+    if (upload.status == UPLOAD_FILE_START) {
+        _updateOk = _otaUpdater.beginUpload(_server.arg("type") == "filesystem", _server.arg("md5"));
+    } else if (upload.status == UPLOAD_FILE_WRITE) {
+        if (_updateOk) {
+            _updateOk = _otaUpdater.writeUpload(upload.buf, upload.currentSize);
+        }
+    } else if (upload.status == UPLOAD_FILE_END) {
+        if (_updateOk) {
+            _updateOk = _otaUpdater.endUpload();
+        }
+    } else if (upload.status == UPLOAD_FILE_ABORTED) {
+        _otaUpdater.abortUpload();
+        _updateOk = false;
+    }
+}
+
+void WebServerController::handleUpdate()
+{
+    DynamicJsonDocument doc(256);
+    if (_updateOk) {
+        doc["success"] = true;
+        doc["restarting"] = true;
+    } else {
+        doc["error"] = _otaUpdater.getUploadError().length() ? _otaUpdater.getUploadError() : String("no image received");
+    }
+    String json;
+    serializeJson(doc, json);
+    _server.send(_updateOk ? 200 : 500, "application/json", json);
+    _updateOk = false;
+}
+
+void WebServerController::handleUpload()
+{
+    if (_uploadFilename == "settings.json") {
+        DeviceSettings *uploaded = new DeviceSettings();
+        bool ok = _uploadValid && _settingsManager.readSettingsFile(SETTINGS_UPLOAD_TMP, *uploaded);
+        LittleFS.remove(SETTINGS_UPLOAD_TMP);
+        if (ok) {
+            // Like a POST to /settings: same pin checks, then the reducer swaps it in and saves it
+            dropUnsafePins(*uploaded);
+            applySettings(uploaded, true);
+            Log.infoln("[Web] Uploaded settings applied without restart.");
+            _server.send(200, "text/plain", "Settings uploaded and applied.");
+        } else {
+            delete uploaded;
+            _server.send(400, "text/plain", "Invalid settings file. Current settings kept.");
+        }
+    } else {
+        _server.send(200, "text/plain", "File uploaded successfully.");
     }
+    _uploadFilename = "";
 }
 
 String WebServerController::getContentType(const String &filePath)
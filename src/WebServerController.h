@@ -7,11 +7,17 @@
 #include "LedController.h"
 #include "Scheduler.h"
 #include "TimeManager.h"
+#include "MDNSManager.h"
+#include "CrashLog.h"
+#include "IrManager.h"
+#include "TaskRunner.h"
+#include "CommandQueue.h"
+#include "OTAUpdater.h"
 
 class WebServerController
 {
 public:
-    WebServerController(int port, WebSocketsServer &ws, SettingsManager &settingsMgr, LedController &ledCtrl, Scheduler &scheduler, TimeManager &timeMgr);
+    WebServerController(int port, WebSocketsServer &ws, SettingsManager &settingsMgr, LedController &ledCtrl, Scheduler &scheduler, TimeManager &timeMgr, MDNSManager &mdnsMgr, CrashLog &crashLog, IrManager &irMgr, TaskRunner &taskRunner, CommandQueue &commands, OTAUpdater &otaUpdater);
     void begin();
     void handleClient();
     void serveFile(const String &filePath);
@@ -21,11 +27,20 @@ private:
     ESP8266WebServer _server;
     File fsUploadFile;
     String _uploadFilename;
+    size_t _uploadSize = 0;
+    bool _uploadValid = false;
     WebSocketsServer &_ws;
     SettingsManager &_settingsManager;
     LedController &_ledController;
     Scheduler &_scheduler;
     TimeManager &_timeManager;
+    MDNSManager &_mdnsManager;
+    CrashLog &_crashLog;
+    IrManager &_irManager;
+    TaskRunner &_taskRunner;
+    CommandQueue &_commands;
+    OTAUpdater &_otaUpdater;
+    bool _updateOk = false;
 
     unsigned long _lastHeapTime = 0;
 
@@ -37,8 +52,18 @@ private:
     void handleDownloadSettings();
     void handleFileUpload();
     void handleUpload();
+    void handleUpdateUpload();
+    void handleUpdate();
+    void applySettings(DeviceSettings *settings, bool persist);
+    static void dropUnsafePins(DeviceSettings &settings);
     void handleRestart();
     void handleHeap();
+    void handleCrashLog();
+    void handleIrLearnStart();
+    void handleIrLearnStatus();
+    void handleScene();
+    void handleTasks();
+    void handleProfile();
     void broadcastHeap();
 };
 
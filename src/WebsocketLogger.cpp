@@ -1,48 +1,435 @@
 #include "WebsocketLogger.h"
 #include <ArduinoLog.h>
 
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
+
 WebsocketLogger::WebsocketLogger(WebSocketsServer &server)
-    : _webSocket(server), _bufferIndex(0) {}
+    : _webSocket(server), _head(0), _tail(0), _droppedBytes(0), _reportedDrops(0), _frameIndex(0),
+      _lineCount(0), _lineStart(0), _lastLevel(LOG_LEVEL_INFO), _recordIndex(0), _recordRemaining(0),
+      _recordExpectLength(false), _serialRoom(0), _serialCut(false), _serialRecord(false), _serialSkipped(0),
+      _backlogLength(0), _backlogTotal(0), _started(false), _crashLog(nullptr)
+{
+    memset(_subscriptions, 0, sizeof(_subscriptions));
+}
 
 void WebsocketLogger::begin()
 {
     _webSocket.onEvent([this](uint8_t num, WStype_t type, uint8_t *payload, size_t length)
                        { webSocketEvent(num, type, payload, length); });
+    // Until now logs went straight to Serial so boot messages are never dropped
+    _started = true;
 }
 
 void WebsocketLogger::loop()
 {
     _webSocket.loop();
+    drain(LOG_FLUSH_BUDGET);
+    reportDrops();
 }
 
 size_t WebsocketLogger::write(uint8_t character)
 {
-    if (_bufferIndex < LOG_BUFFER_SIZE - 1) {
-        _buffer[_bufferIndex++] = character;
-        if (character == '\n') {
-            flush();
-        }
-    } else {
-        flush();
-        _buffer[_bufferIndex++] = character;
+    if (!_started) {
+        return Serial.write(character);
     }
-    return Serial.write(character);
+
+    uint16_t head = _head;
+    uint16_t next = (head + 1) & LOG_RING_MASK;
+    if (next == _tail) {
+        _droppedBytes++;
+        return 1; // Report success so Print keeps going; the loss is counted
+    }
+    _ring[head] = character;
+    _head = next;
+    return 1;
 }
 
 size_t WebsocketLogger::write(const uint8_t *buffer, size_t size)
 {
-    for (size_t i = 0; i < size; i++) {
-        write(buffer[i]);
+    if (!_started) {
+        return Serial.write(buffer, size);
+    }
+
+    uint16_t head = _head;
+    size_t space = (_tail - head - 1) & LOG_RING_MASK;
+    size_t count = size < space ? size : space;
+    if (count < size && size > 0 && buffer[0] == LOG_RECORD_MARKER) {
+        count = 0; // A truncated token record would corrupt the stream, drop it whole
     }
+    _droppedBytes += size - count;
+
+    // Copy in at most two segments around the wrap point
+    size_t first = LOG_RING_SIZE - head;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(&_ring[head], buffer, first);
+    memcpy(&_ring[0], buffer + first, count - first);
+    _head = (head + count) & LOG_RING_MASK;
     return size;
 }
 
+void WebsocketLogger::drain(size_t budget, bool blockSerial)
+{
+    uint16_t tail = _tail;
+    size_t available = (_head - tail) & LOG_RING_MASK;
+    if (available > budget) {
+        available = budget;
+    }
+    // The UART only gets what fits in its TX buffer, unless the caller may block
+    _serialRoom = blockSerial ? SIZE_MAX : Serial.availableForWrite();
+
+    while (available > 0) {
+        size_t chunk = LOG_RING_SIZE - tail;
+        if (chunk > available) {
+            chunk = available;
+        }
+        const char *segment = &_ring[tail];
+        for (size_t i = 0; i < chunk; i++) {
+            mirror(segment[i]);
+            consume(segment[i]);
+        }
+        tail = (tail + chunk) & LOG_RING_MASK;
+        available -= chunk;
+    }
+    _tail = tail;
+
+    // Batch whole lines: only ship the frame once it ends on a line boundary
+    if (_lineCount > 0 && _lineStart == _frameIndex) {
+        sendFrame();
+    }
+    if (_recordRemaining == 0 && !_recordExpectLength) {
+        sendRecordFrame();
+    }
+}
+
+void WebsocketLogger::mirror(char c)
+{
+    // Runs before consume(), so the record state still describes the byte before c
+    if (_recordExpectLength) {
+        // A record goes out whole or not at all, a partial one would garble the decoder
+        size_t length = (uint8_t)c + 2;
+        _serialRecord = _serialRoom >= length;
+        if (_serialRecord) {
+            Serial.write((uint8_t)LOG_RECORD_MARKER);
+            Serial.write((uint8_t)c);
+            _serialRoom -= 2;
+        } else {
+            _serialSkipped += length;
+        }
+        return;
+    }
+    if (_recordRemaining > 0) {
+        if (_serialRecord) {
+            Serial.write((uint8_t)c);
+            _serialRoom--;
+        }
+        return;
+    }
+    if ((uint8_t)c == LOG_RECORD_MARKER) {
+        return; // Decided once the length byte arrives
+    }
+    if (c == '\n') {
+        if (_serialRoom > 0) {
+            Serial.write((uint8_t)c);
+            _serialRoom--;
+            _serialCut = false;
+        } else {
+            _serialSkipped++;
+        }
+        return;
+    }
+    // Keep the last free byte for the newline that ends a cut line
+    if (_serialCut || _serialRoom < 2) {
+        _serialCut = true;
+        _serialSkipped++;
+        return;
+    }
+    Serial.write((uint8_t)c);
+    _serialRoom--;
+}
+
+void WebsocketLogger::consume(char c)
+{
+    if (_recordExpectLength) {
+        _records[_recordIndex++] = c;
+        _recordRemaining = (uint8_t)c;
+        _recordExpectLength = false;
+        return;
+    }
+    if (_recordRemaining > 0) {
+        _records[_recordIndex++] = c;
+        _recordRemaining--;
+        return;
+    }
+    if ((uint8_t)c == LOG_RECORD_MARKER) {
+        // Keep ordering between text and token records: flush text before the record
+        sendFrame();
+        if (_recordIndex + LOG_RECORD_MAX + 2 > LOG_FRAME_SIZE) {
+            sendRecordFrame();
+        }
+        _records[_recordIndex++] = c;
+        _recordExpectLength = true;
+        return;
+    }
+
+    sendRecordFrame();
+    _frame[_frameIndex++] = c;
+    if (c == '\n' || _frameIndex == LOG_FRAME_SIZE - 1) {
+        closeLine();
+    }
+    if (_frameIndex == LOG_FRAME_SIZE - 1 || _lineCount == LOG_FRAME_MAX_LINES) {
+        sendFrame();
+    }
+}
+
+void WebsocketLogger::sendRecordFrame()
+{
+    if (_recordIndex == 0) {
+        return;
+    }
+    for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++) {
+        const Subscription &sub = _subscriptions[num];
+        if (!sub.active) {
+            continue;
+        }
+        if (sub.maxLevel >= LOG_LEVEL_VERBOSE) {
+            _webSocket.sendBIN(num, (uint8_t *)_records, _recordIndex);
+            continue;
+        }
+        // Tags live in the format string, so only the level filter applies on device
+        size_t length = 0;
+        size_t pos = 0;
+        while (pos + 2 < _recordIndex) {
+            size_t recordLength = (uint8_t)_records[pos + 1] + 2;
+            if ((uint8_t)_records[pos + 2] <= sub.maxLevel) {
+                memcpy(&_scratch[length], &_records[pos], recordLength);
+                length += recordLength;
+            }
+            pos += recordLength;
+        }
+        if (length > 0) {
+            _webSocket.sendBIN(num, (uint8_t *)_scratch, length);
+        }
+    }
+    _recordIndex = 0;
+}
+
+void WebsocketLogger::closeLine()
+{
+    LogLine &line = _lines[_lineCount++];
+    line.start = _lineStart;
+    line.length = _frameIndex - _lineStart;
+    // Continuation lines without a "X: " prefix inherit the previous level
+    line.level = parseLevel(&_frame[_lineStart], line.length, _lastLevel);
+    _lastLevel = line.level;
+    _lineStart = _frameIndex;
+}
+
+void WebsocketLogger::sendFrame()
+{
+    if (_lineStart < _frameIndex) {
+        closeLine(); // Flush a trailing partial line as its own line
+    }
+    if (_lineCount == 0) {
+        return;
+    }
+
+    for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++) {
+        const Subscription &sub = _subscriptions[num];
+        if (!sub.active) {
+            continue;
+        }
+        if (sub.maxLevel >= LOG_LEVEL_VERBOSE && sub.tags[0] == '\0') {
+            _webSocket.sendTXT(num, (uint8_t *)_frame, _frameIndex);
+            continue;
+        }
+        // Filtered client: pack only the matching lines into the scratch frame
+        size_t length = 0;
+        for (size_t i = 0; i < _lineCount; i++) {
+            const LogLine &line = _lines[i];
+            if (accepts(sub, &_frame[line.start], line.length, line.level)) {
+                memcpy(&_scratch[length], &_frame[line.start], line.length);
+                length += line.length;
+            }
+        }
+        if (length > 0) {
+            _webSocket.sendTXT(num, (uint8_t *)_scratch, length);
+        }
+    }
+
+    appendBacklog(_frame, _frameIndex);
+    if (_crashLog != nullptr) {
+        _crashLog->append(_frame, _frameIndex);
+    }
+    _frameIndex = 0;
+    _lineCount = 0;
+    _lineStart = 0;
+}
+
+void WebsocketLogger::appendBacklog(const char *data, size_t length)
+{
+    if (length >= LOG_BACKLOG_SIZE) {
+        data += length - (LOG_BACKLOG_SIZE - 1);
+        length = LOG_BACKLOG_SIZE - 1;
+    }
+    if (_backlogLength + length > LOG_BACKLOG_SIZE) {
+        // Evict the oldest whole lines to make room
+        size_t evict = _backlogLength + length - LOG_BACKLOG_SIZE;
+        while (evict < _backlogLength && _backlog[evict - 1] != '\n') {
+            evict++;
+        }
+        memmove(_backlog, &_backlog[evict], _backlogLength - evict);
+        _backlogLength -= evict;
+    }
+    memcpy(&_backlog[_backlogLength], data, length);
+    _backlogLength += length;
+    _backlogTotal += length;
+}
+
+void WebsocketLogger::replayBacklog(uint8_t num)
+{
+    Subscription &sub = _subscriptions[num];
+    if (sub.replayed) {
+        return;
+    }
+    sub.replayed = true;
+    // Only what was logged before the client connected; it got the rest live
+    int32_t before = (int32_t)(sub.seenFrom - (_backlogTotal - _backlogLength));
+    size_t end = before > 0 ? min((size_t)before, _backlogLength) : 0;
+    size_t length = 0;
+    size_t pos = 0;
+    uint8_t level = LOG_LEVEL_INFO;
+
+    while (pos < end) {
+        const char *line = &_backlog[pos];
+        const char *newline = (const char *)memchr(line, '\n', end - pos);
+        size_t lineLength = newline ? (size_t)(newline - line) + 1 : end - pos;
+        pos += lineLength;
+        level = parseLevel(line, lineLength, level);
+        if (lineLength >= LOG_FRAME_SIZE || !accepts(sub, line, lineLength, level)) {
+            continue;
+        }
+        if (length + lineLength > LOG_FRAME_SIZE) {
+            _webSocket.sendTXT(num, (uint8_t *)_scratch, length);
+            length = 0;
+        }
+        memcpy(&_scratch[length], line, lineLength);
+        length += lineLength;
+    }
+    if (length > 0) {
+        _webSocket.sendTXT(num, (uint8_t *)_scratch, length);
+    }
+}
+
+void WebsocketLogger::subscribe(uint8_t num, const char *command)
+{
+    // command is "<level>" or "<level>:<tag>,<tag>"
+    Subscription &sub = _subscriptions[num];
+    int level = atoi(command);
+    sub.maxLevel = constrain(level, LOG_LEVEL_FATAL, LOG_LEVEL_VERBOSE);
+    sub.tags[0] = '\0';
+    const char *tags = strchr(command, ':');
+    if (tags != nullptr) {
+        strncpy(sub.tags, tags + 1, LOG_TAG_FILTER_SIZE - 1);
+        sub.tags[LOG_TAG_FILTER_SIZE - 1] = '\0';
+    }
+}
+
+bool WebsocketLogger::accepts(const Subscription &sub, const char *line, size_t length, uint8_t level) const
+{
+    if (level > sub.maxLevel) {
+        return false;
+    }
+    if (sub.tags[0] == '\0') {
+        return true;
+    }
+
+    // The tag is the first "[Name]" near the start of the line, after the "X: " level prefix
+    const char *open = (const char *)memchr(line, '[', length < 8 ? length : 8);
+    if (open == nullptr) {
+        return false;
+    }
+    const char *close = (const char *)memchr(open, ']', length - (open - line));
+    if (close == nullptr) {
+        return false;
+    }
+    const char *name = open + 1;
+    size_t nameLength = close - name;
+
+    const char *token = sub.tags;
+    while (*token != '\0') {
+        const char *end = strchr(token, ',');
+        size_t tokenLength = end ? (size_t)(end - token) : strlen(token);
+        const char *tokenName = token;
+        // Accept both "LedCtrl" and "[LedCtrl]"
+        if (tokenLength >= 2 && tokenName[0] == '[' && tokenName[tokenLength - 1] == ']') {
+            tokenName++;
+            tokenLength -= 2;
+        }
+        if (tokenLength == nameLength && strncmp(tokenName, name, nameLength) == 0) {
+            return true;
+        }
+        if (end == nullptr) {
+            break;
+        }
+        token = end + 1;
+    }
+    return false;
+}
+
+uint8_t WebsocketLogger::parseLevel(const char *line, size_t length, uint8_t fallback)
+{
+    // ArduinoLog prefixes each message with one of "FEWITV" followed by ": "
+    static const char levels[] = "FEWITV";
+    if (length >= 2 && line[1] == ':') {
+        const char *match = strchr(levels, line[0]);
+        if (match != nullptr && line[0] != '\0') {
+            return (match - levels) + 1;
+        }
+    }
+    return fallback;
+}
+
+void WebsocketLogger::reportDrops()
+{
+    uint32_t dropped = _droppedBytes;
+    if (dropped == _reportedDrops || ((_head - _tail) & LOG_RING_MASK) != 0) {
+        return; // Report only once the backlog has cleared
+    }
+    char message[48];
+    int len = snprintf(message, sizeof(message), "W: [Log] %lu bytes dropped\n", (unsigned long)(dropped - _reportedDrops));
+    _reportedDrops = dropped;
+    write((const uint8_t *)message, len);
+}
+
 void WebsocketLogger::flush() {
-    if (_bufferIndex > 0) {
-        _buffer[_bufferIndex] = '\0'; // Null-terminate the string
-        _webSocket.broadcastTXT((uint8_t*)_buffer, _bufferIndex);
-        _bufferIndex = 0;
+    while (((_head - _tail) & LOG_RING_MASK) != 0) {
+        drain(LOG_RING_SIZE, true);
+        yield();
     }
+    sendFrame();
+    sendRecordFrame();
+}
+
+uint32_t WebsocketLogger::getDroppedBytes() const
+{
+    return _droppedBytes;
+}
+
+uint32_t WebsocketLogger::getSerialSkippedBytes() const
+{
+    return _serialSkipped;
+}
+
+void WebsocketLogger::setCrashLog(CrashLog *crashLog)
+{
+    _crashLog = crashLog;
+}
+
+void WebsocketLogger::onCommand(CommandHandler handler)
+{
+    _commandHandler = handler;
 }
 
 void WebsocketLogger::webSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length)
@@ -50,16 +437,37 @@ void WebsocketLogger::webSocketEvent(uint8_t num, WStype_t type, uint8_t *payloa
     switch (type)
     {
     case WStype_DISCONNECTED:
+        _subscriptions[num].active = false;
         Log.info("[WebSocket] Client #%u disconnected.\n", num);
         break;
     case WStype_CONNECTED:
     {
+        // New clients get everything until they subscribe with a filter
+        Subscription &sub = _subscriptions[num];
+        sub.active = true;
+        sub.replayed = false;
+        sub.seenFrom = _backlogTotal;
+        sub.maxLevel = LOG_LEVEL_VERBOSE;
+        sub.tags[0] = '\0';
         IPAddress ip = _webSocket.remoteIP(num);
         Log.info("[WebSocket] Client #%u connected from %d.%d.%d.%d url: %s\n", num, ip[0], ip[1], ip[2], ip[3], payload);
     }
     break;
     case WStype_TEXT:
-        // Not expecting any text from clients, but you could handle it here
+        if (length == 5 && strncmp((const char *)payload, "ready", 5) == 0)
+        {
+            replayBacklog(num);
+        }
+        else if (length > 10 && strncmp((const char *)payload, "subscribe:", 10) == 0)
+        {
+            // payload is null-terminated by the WebSockets library
+            subscribe(num, (const char *)payload + 10);
+            replayBacklog(num);
+        }
+        else if (_commandHandler)
+        {
+            _commandHandler(num, (const char *)payload, length);
+        }
         break;
     case WStype_BIN:
     case WStype_ERROR:
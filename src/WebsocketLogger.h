@@ -3,22 +3,113 @@
 
 #include <Arduino.h>
 #include <WebSocketsServer.h>
+#include "LogToken.h"
+#include "CrashLog.h"
 
-#define LOG_BUFFER_SIZE 256
+#define LOG_RING_SIZE 2048       // Must be a power of two
+#define LOG_FRAME_SIZE 512       // Max bytes per WebSocket frame
+#define LOG_FRAME_MAX_LINES 32   // Max log lines batched into one frame
+#define LOG_FLUSH_BUDGET 512     // Max bytes drained from the ring per loop() tick
+#define LOG_BACKLOG_SIZE 1024    // Recent lines replayed to clients once they subscribe
+#define LOG_TAG_FILTER_SIZE 64   // Comma separated tag list per client, e.g. "LedCtrl,Scheduler"
 
+/**
+ * Print sink for ArduinoLog. Producers append into a single-producer /
+ * single-consumer ring buffer in O(1); loop() batches complete lines into
+ * WebSocket frames within a per-tick budget. When the ring is full new bytes
+ * are dropped and counted, never blocking.
+ *
+ * Serial gets a copy of whatever fits in its TX FIFO at the time. It never
+ * holds the ring back: once the FIFO is full the rest of the line is left
+ * out on Serial (the newline still goes out when there is room) and whole
+ * token records are skipped, so a slow UART costs Serial output, not
+ * WebSocket output. flush() waits for the UART and loses nothing.
+ *
+ * Each WebSocket client can narrow what it receives by sending
+ * "subscribe:<level>:<tags>" (level is a LOG_LEVEL_* number, tags an
+ * optional comma separated list such as "LedCtrl,Scheduler"). The first
+ * "ready" or subscribe command on a connection replays the matching part of
+ * the backlog up to where the client connected; later ones only change the
+ * filter, so no line arrives twice.
+ *
+ * Any other text message goes to the handler set with onCommand(), e.g.
+ * "scene:<name>" from the web UI.
+ *
+ * Tokenized records (see LogToken.h) pass through to Serial unchanged and
+ * are sent to clients as binary frames, filtered by level only.
+ */
 class WebsocketLogger : public Print {
 public:
+    // Receives text messages that aren't logger commands; text is null-terminated
+    typedef std::function<void(uint8_t num, const char *text, size_t length)> CommandHandler;
+
     WebsocketLogger(WebSocketsServer& server);
     void begin();
     void loop();
     virtual size_t write(uint8_t);
     virtual size_t write(const uint8_t *buffer, size_t size);
     void flush();
+    uint32_t getDroppedBytes() const;
+    uint32_t getSerialSkippedBytes() const;
+    void setCrashLog(CrashLog *crashLog);
+    void onCommand(CommandHandler handler);
 
 private:
+    struct LogLine {
+        uint16_t start;
+        uint16_t length;
+        uint8_t level;
+    };
+
+    struct Subscription {
+        bool active;
+        bool replayed;      // Backlog already sent on this connection
+        uint32_t seenFrom;  // Backlog position at connect; later lines reached the client live
+        uint8_t maxLevel;
+        char tags[LOG_TAG_FILTER_SIZE];
+    };
+
     WebSocketsServer& _webSocket;
-    char _buffer[LOG_BUFFER_SIZE];
-    size_t _bufferIndex;
+    char _ring[LOG_RING_SIZE];
+    volatile uint16_t _head; // Written by the producer only
+    volatile uint16_t _tail; // Written by the consumer only
+    uint32_t _droppedBytes;
+    uint32_t _reportedDrops;
+    char _frame[LOG_FRAME_SIZE];
+    size_t _frameIndex;
+    LogLine _lines[LOG_FRAME_MAX_LINES];
+    size_t _lineCount;
+    size_t _lineStart;
+    uint8_t _lastLevel;
+    char _records[LOG_FRAME_SIZE];
+    size_t _recordIndex;
+    uint8_t _recordRemaining;
+    bool _recordExpectLength;
+    size_t _serialRoom;     // Bytes Serial takes without blocking during this drain
+    bool _serialCut;        // Rest of the current text line is left out on Serial
+    bool _serialRecord;     // Current token record is copied to Serial
+    uint32_t _serialSkipped;
+    char _scratch[LOG_FRAME_SIZE];
+    char _backlog[LOG_BACKLOG_SIZE];
+    size_t _backlogLength;
+    uint32_t _backlogTotal; // Bytes ever appended to the backlog, positions survive eviction
+    Subscription _subscriptions[WEBSOCKETS_SERVER_CLIENT_MAX];
+    bool _started;
+    CrashLog *_crashLog;
+    CommandHandler _commandHandler;
+
+    void drain(size_t budget, bool blockSerial = false);
+    void consume(char c);
+    void mirror(char c);
+    void closeLine();
+    void sendRecordFrame();
+    void sendFrame();
+    void appendBacklog(const char *data, size_t length);
+    void replayBacklog(uint8_t num);
+    void reportDrops();
+    void subscribe(uint8_t num, const char *command);
+    bool accepts(const Subscription &sub, const char *line, size_t length, uint8_t level) const;
+    static uint8_t parseLevel(const char *line, size_t length, uint8_t fallback);
     void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length);
 };
 
@@ -1,13 +1,26 @@
 #include "WifiConnector.h"
+#include "RtcMemory.h"
+#include <LittleFS.h>
 #include <ArduinoLog.h>
 
-WiFiConnector::WiFiConnector(const char *ssid, const char *password, int statusLedPin)
-    : _ssid(ssid), _password(password), _statusLedPin(statusLedPin)
+#define WIFI_CACHE_MAGIC 0x57494632 // "WIF2"
+
+WiFiConnector::WiFiConnector(int statusLedPin)
+    : _statusLedPin(statusLedPin)
 {
+    _started = false;
     _currentState = WIFI_IDLE;
+    _cacheLoaded = false;
+    _cacheValid = false;
+    _directConnect = false;
+    _leaseReused = false;
     _lastAttemptTimestamp = 0;
     _lastPulseTimestamp = 0;
+    _lastRoamCheck = 0;
+    _lastRoamScan = 0;
+    _roamScanning = false;
     _ledPulseState = false;
+    memset(&_cache, 0, sizeof(_cache));
     if (_statusLedPin != -1)
     {
         pinMode(_statusLedPin, OUTPUT);
@@ -15,13 +28,125 @@ WiFiConnector::WiFiConnector(const char *ssid, const char *password, int statusL
     }
 }
 
+void WiFiConnector::setStaticIp(const IPAddress &ip, const IPAddress &gateway, const IPAddress &subnet, const IPAddress &dns)
+{
+    _staticIp = ip;
+    _staticGateway = gateway;
+    _staticSubnet = subnet;
+    _staticDns = dns;
+}
+
+void WiFiConnector::setNetworks(const std::vector<WifiNetwork> &networks)
+{
+    bool changed = networks.size() != _networks.size();
+    for (size_t i = 0; !changed && i < networks.size(); i++)
+    {
+        changed = networks[i].ssid != _networks[i].ssid || networks[i].password != _networks[i].password;
+    }
+    _networks = networks;
+    if (!changed || !_started)
+        return;
+
+    Log.infoln("[WiFi] %d known network(s).", (int)_networks.size());
+    if (_currentState == WIFI_SETUP_AP)
+    {
+        WiFi.softAPdisconnect(true);
+    }
+    else if (isConnected() && findNetwork(ssidHash(WiFi.SSID())))
+    {
+        return; // Still a known network; new entries are considered when roaming
+    }
+    connect();
+}
+
 void WiFiConnector::connect()
 {
     Log.infoln("[WiFi] Starting connection process...");
+    _started = true;
+    if (_roamScanning)
+    {
+        WiFi.scanDelete();
+        _roamScanning = false;
+    }
+    WiFi.persistent(false); // Credentials come from settings, don't rewrite the SDK's flash copy on every begin()
+
+    if (_networks.empty())
+    {
+        // Nothing to join: offer an open AP so networks can be added from the web UI
+        Log.infoln("[WiFi] No networks configured, starting setup AP %s.", WIFI_SETUP_AP_SSID);
+        WiFi.mode(WIFI_AP);
+        WiFi.softAP(WIFI_SETUP_AP_SSID);
+        _currentState = WIFI_SETUP_AP;
+        return;
+    }
+
+    WiFi.mode(WIFI_STA);
     WiFi.setSleepMode(WIFI_NONE_SLEEP); // Disable WiFi sleep mode
+
+    loadCache();
+    const WifiNetwork *cached = _cacheValid ? findNetwork(_cache.ssidHash) : nullptr;
+    if (cached)
+    {
+        // Known BSSID and channel: associate directly instead of scanning every channel
+        Log.infoln("[WiFi] Reconnecting to cached AP of %s on channel %d.", cached->ssid.c_str(), _cache.channel);
+        applyIpConfig(true);
+        connectDirect(*cached, _cache.channel, _cache.bssid);
+    }
+    else
+    {
+        applyIpConfig(false);
+        startScan();
+    }
+}
+
+void WiFiConnector::connectDirect(const WifiNetwork &network, int32_t channel, const uint8_t *bssid)
+{
+    _directConnect = true;
     _currentState = WIFI_CONNECTING;
     _lastAttemptTimestamp = millis();
-    WiFi.begin(_ssid, _password);
+    WiFi.begin(network.ssid.c_str(), network.password.c_str(), channel, bssid);
+}
+
+void WiFiConnector::startScan()
+{
+    // One async scan serves all known networks; the strongest one in range wins
+    _directConnect = false;
+    _currentState = WIFI_SCANNING;
+    _lastAttemptTimestamp = millis();
+    WiFi.scanNetworks(true);
+}
+
+void WiFiConnector::handleScanResult()
+{
+    int count = WiFi.scanComplete();
+    if (count == WIFI_SCAN_RUNNING)
+    {
+        if (millis() - _lastAttemptTimestamp > SCAN_TIMEOUT)
+        {
+            Log.infoln("[WiFi] Scan timed out. Will retry...");
+            _currentState = WIFI_FAILED_WAITING;
+            _lastAttemptTimestamp = millis();
+        }
+        return;
+    }
+
+    int networkIndex;
+    int best = count > 0 ? findBest(networkIndex) : -1;
+    if (best < 0)
+    {
+        Log.infoln("[WiFi] No known network in range. Will retry...");
+        WiFi.scanDelete();
+        _currentState = WIFI_FAILED_WAITING;
+        _lastAttemptTimestamp = millis();
+        return;
+    }
+
+    const WifiNetwork &network = _networks[networkIndex];
+    Log.infoln("[WiFi] Joining %s (%d dBm, channel %d).", network.ssid.c_str(), WiFi.RSSI(best), WiFi.channel(best));
+    _currentState = WIFI_CONNECTING;
+    _lastAttemptTimestamp = millis();
+    WiFi.begin(network.ssid.c_str(), network.password.c_str(), WiFi.channel(best), WiFi.BSSID(best));
+    WiFi.scanDelete();
 }
 
 void WiFiConnector::handleConnection()
@@ -30,15 +155,27 @@ void WiFiConnector::handleConnection()
     {
         if (WiFi.status() == WL_CONNECTED)
         {
-            Log.infoln("\n[WiFi] Connection successful!");
+            Log.infoln("\n[WiFi] Connection successful in %u ms%s!", (unsigned long)(millis() - _lastAttemptTimestamp), _directConnect ? " (direct)" : "");
             Serial.print("[WiFi] IP Address: ");
             Log.infoln(WiFi.localIP());
             _currentState = WIFI_IDLE;
+            _lastRoamCheck = millis();
+            saveCache();
             if (_statusLedPin != -1)
             {
                 digitalWrite(_statusLedPin, HIGH); // Turn LED off
             }
         }
+        else if (_directConnect && (millis() - _lastAttemptTimestamp > FAST_CONNECT_TIMEOUT ||
+                                    WiFi.status() == WL_NO_SSID_AVAIL || WiFi.status() == WL_CONNECT_FAILED))
+        {
+            // The AP moved, changed channel or is gone; forget it and scan right away
+            Log.infoln("[WiFi] AP did not answer, falling back to a full scan.");
+            invalidateCache();
+            WiFi.disconnect();
+            applyIpConfig(false);
+            startScan();
+        }
         else if (millis() - _lastAttemptTimestamp > CONNECTION_TIMEOUT)
         {
             Log.infoln("\n[WiFi] Connection failed. Will retry...");
@@ -60,6 +197,10 @@ void WiFiConnector::handleConnection()
             }
         }
     }
+    else if (_currentState == WIFI_SCANNING)
+    {
+        handleScanResult();
+    }
     else if (_currentState == WIFI_FAILED_WAITING)
     {
         // Solid ON during wait period
@@ -77,9 +218,189 @@ void WiFiConnector::handleConnection()
         Log.infoln("[WiFi] Connection lost. Attempting to reconnect...");
         connect();
     }
+    else if (_currentState == WIFI_IDLE)
+    {
+        handleRoaming();
+    }
+}
+
+void WiFiConnector::handleRoaming()
+{
+    if (_roamScanning)
+    {
+        int count = WiFi.scanComplete();
+        if (count == WIFI_SCAN_RUNNING)
+        {
+            if (millis() - _lastRoamScan > SCAN_TIMEOUT)
+            {
+                WiFi.scanDelete();
+                _roamScanning = false;
+            }
+            return;
+        }
+        _roamScanning = false;
+
+        int networkIndex;
+        int best = count > 0 ? findBest(networkIndex) : -1;
+        if (best < 0 || memcmp(WiFi.BSSID(best), WiFi.BSSID(), 6) == 0 || WiFi.RSSI(best) < WiFi.RSSI() + ROAM_HYSTERESIS)
+        {
+            WiFi.scanDelete();
+            return;
+        }
+
+        const WifiNetwork &network = _networks[networkIndex];
+        Log.infoln("[WiFi] Roaming from %d dBm to %s at %d dBm.", WiFi.RSSI(), network.ssid.c_str(), WiFi.RSSI(best));
+        uint8_t bssid[6];
+        memcpy(bssid, WiFi.BSSID(best), sizeof(bssid));
+        int32_t channel = WiFi.channel(best);
+        bool sameNetwork = network.ssid == WiFi.SSID();
+        WiFi.scanDelete();
+        // Another AP of the same network keeps the lease; a different network needs DHCP
+        applyIpConfig(sameNetwork);
+        connectDirect(network, channel, bssid);
+        return;
+    }
+
+    if (millis() - _lastRoamCheck < ROAM_CHECK_INTERVAL)
+        return;
+    _lastRoamCheck = millis();
+    if (WiFi.RSSI() >= ROAM_RSSI_THRESHOLD || (_lastRoamScan != 0 && millis() - _lastRoamScan < ROAM_SCAN_INTERVAL))
+        return;
+
+    // Weak link: look for a better AP in the background while staying connected
+    Log.infoln("[WiFi] Signal at %d dBm, scanning for a better AP.", WiFi.RSSI());
+    WiFi.scanNetworks(true);
+    _roamScanning = true;
+    _lastRoamScan = millis();
+}
+
+int WiFiConnector::findBest(int &networkIndex)
+{
+    int best = -1;
+    int count = WiFi.scanComplete();
+    for (int i = 0; i < count; i++)
+    {
+        for (size_t n = 0; n < _networks.size(); n++)
+        {
+            if (WiFi.SSID(i) == _networks[n].ssid && (best < 0 || WiFi.RSSI(i) > WiFi.RSSI(best)))
+            {
+                best = i;
+                networkIndex = n;
+            }
+        }
+    }
+    return best;
+}
+
+const WifiNetwork *WiFiConnector::findNetwork(uint32_t hash)
+{
+    for (const auto &network : _networks)
+    {
+        if (ssidHash(network.ssid) == hash)
+            return &network;
+    }
+    return nullptr;
 }
 
 bool WiFiConnector::isConnected()
 {
     return WiFi.status() == WL_CONNECTED;
-}
\ No newline at end of file
+}
+
+void WiFiConnector::applyIpConfig(bool useCachedLease)
+{
+    _leaseReused = false;
+    if (_staticIp.isSet())
+    {
+        WiFi.config(_staticIp, _staticGateway, _staticSubnet, _staticDns);
+        return;
+    }
+    if (useCachedLease && _cacheValid && _cache.leaseReuses >= LEASE_MAX_REUSES)
+    {
+        Log.infoln("[WiFi] Cached lease used %d times, renewing it over DHCP.", _cache.leaseReuses);
+    }
+    else if (useCachedLease && _cacheValid)
+    {
+        // Reuse the last lease and skip DHCP
+        WiFi.config(IPAddress(_cache.ip), IPAddress(_cache.gateway), IPAddress(_cache.subnet), IPAddress(_cache.dns));
+        _leaseReused = true;
+        return;
+    }
+    WiFi.config(0U, 0U, 0U); // Back to DHCP
+}
+
+uint32_t WiFiConnector::ssidHash(const String &ssid)
+{
+    return rtcChecksum(ssid.c_str(), ssid.length());
+}
+
+uint32_t WiFiConnector::cacheChecksum(const Cache &cache)
+{
+    return rtcChecksum(&cache, offsetof(Cache, checksum));
+}
+
+void WiFiConnector::loadCache()
+{
+    if (_cacheLoaded)
+        return;
+    _cacheLoaded = true;
+
+    // RTC memory after a reset, otherwise the flash copy
+    Cache cache;
+    bool valid = ESP.rtcUserMemoryRead(RTC_BLOCK_WIFI_CACHE, (uint32_t *)&cache, sizeof(cache)) &&
+                 cache.magic == WIFI_CACHE_MAGIC && cache.checksum == cacheChecksum(cache);
+    if (!valid)
+    {
+        File file = LittleFS.open(WIFI_CACHE_FILE, "r");
+        if (file)
+        {
+            valid = file.read((uint8_t *)&cache, sizeof(cache)) == sizeof(cache) &&
+                    cache.magic == WIFI_CACHE_MAGIC && cache.checksum == cacheChecksum(cache);
+            file.close();
+        }
+    }
+    _cacheValid = valid && cache.channel >= 1 && cache.channel <= 14;
+    if (_cacheValid)
+    {
+        _cache = cache;
+    }
+}
+
+void WiFiConnector::saveCache()
+{
+    Cache cache;
+    memset(&cache, 0, sizeof(cache));
+    cache.magic = WIFI_CACHE_MAGIC;
+    cache.ssidHash = ssidHash(WiFi.SSID());
+    memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+    cache.channel = WiFi.channel();
+    // A lease fresh from DHCP starts counting again
+    cache.leaseReuses = _leaseReused ? _cache.leaseReuses + 1 : 0;
+    cache.ip = WiFi.localIP();
+    cache.gateway = WiFi.gatewayIP();
+    cache.subnet = WiFi.subnetMask();
+    cache.dns = WiFi.dnsIP();
+    cache.checksum = cacheChecksum(cache);
+
+    // Only touch flash when the AP or lease actually changed
+    if (_cacheValid && memcmp(&cache, &_cache, sizeof(cache)) == 0)
+        return;
+    _cache = cache;
+    _cacheValid = true;
+    ESP.rtcUserMemoryWrite(RTC_BLOCK_WIFI_CACHE, (uint32_t *)&_cache, sizeof(_cache));
+    File file = LittleFS.open(WIFI_CACHE_FILE, "w");
+    if (file)
+    {
+        file.write((const uint8_t *)&_cache, sizeof(_cache));
+        file.close();
+    }
+    Log.infoln("[WiFi] Cached AP on channel %d for fast reconnects.", _cache.channel);
+}
+
+void WiFiConnector::invalidateCache()
+{
+    _cacheValid = false;
+    memset(&_cache, 0, sizeof(_cache));
+    ESP.rtcUserMemoryWrite(RTC_BLOCK_WIFI_CACHE, (uint32_t *)&_cache, sizeof(_cache));
+    LittleFS.remove(WIFI_CACHE_FILE);
+}
@@ -2,33 +2,99 @@
 #define WIFI_CONNECTOR_H
 
 #include <ESP8266WiFi.h>
+#include <vector>
+#include "SettingsManager.h" // For WifiNetwork
+
+#define WIFI_CACHE_FILE "/wifi.bin"
+#define WIFI_SETUP_AP_SSID "ledbar-setup" // Open AP for the web UI while no network is known
 
 class WiFiConnector {
 public:
-    WiFiConnector(const char* ssid, const char* password, int statusLedPin = -1);
+    WiFiConnector(int statusLedPin = -1);
     void connect();
     void handleConnection();
     bool isConnected();
 
+    /**
+     * @brief Replaces the known networks. Reconnects only if the current link is no longer covered.
+     */
+    void setNetworks(const std::vector<WifiNetwork>& networks);
+
+    /**
+     * @brief Uses a fixed address instead of DHCP or the cached lease. Call before connect().
+     */
+    void setStaticIp(const IPAddress& ip, const IPAddress& gateway, const IPAddress& subnet, const IPAddress& dns);
+
 private:
-    const char* _ssid;
-    const char* _password;
+    std::vector<WifiNetwork> _networks;
     int _statusLedPin;
+    bool _started;
 
     enum WiFiState {
         WIFI_IDLE,
+        WIFI_SCANNING,
         WIFI_CONNECTING,
-        WIFI_FAILED_WAITING
+        WIFI_FAILED_WAITING,
+        WIFI_SETUP_AP
     };
     WiFiState _currentState;
 
+    // Last AP and lease, kept in RTC memory and flash so reconnects skip the scan and DHCP.
+    // The lease is reused for LEASE_MAX_REUSES connects, then DHCP is asked again so an
+    // address the router has since given away or renumbered doesn't stick forever.
+    struct Cache {
+        uint32_t magic;
+        uint32_t ssidHash;
+        uint8_t bssid[6];
+        uint8_t channel;
+        uint8_t leaseReuses; // Connects on this lease since DHCP handed it out
+        uint32_t ip;
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns;
+        uint32_t checksum;
+    };
+    Cache _cache;
+    bool _cacheLoaded;
+    bool _cacheValid;
+    bool _directConnect; // Current attempt targets one BSSID (cache or roam) and falls back to a scan
+    bool _leaseReused;   // Current attempt applied the cached lease instead of DHCP
+
+    IPAddress _staticIp;
+    IPAddress _staticGateway;
+    IPAddress _staticSubnet;
+    IPAddress _staticDns;
+
     unsigned long _lastAttemptTimestamp;
     unsigned long _lastPulseTimestamp;
+    unsigned long _lastRoamCheck;
+    unsigned long _lastRoamScan;
+    bool _roamScanning;
     bool _ledPulseState;
 
     const unsigned long CONNECTION_TIMEOUT = 30000; // 30 seconds
+    const unsigned long FAST_CONNECT_TIMEOUT = 3000; // Cached AP should answer well within this
+    const uint8_t LEASE_MAX_REUSES = 4;              // Connects on a cached lease before DHCP runs again
+    const unsigned long SCAN_TIMEOUT = 10000;
     const unsigned long RETRY_WAIT_PERIOD = 5000;   // 5 seconds
     const unsigned long LED_PULSE_INTERVAL = 2000;  // 2 seconds
+    const unsigned long ROAM_CHECK_INTERVAL = 10000; // How often RSSI is sampled while connected
+    const unsigned long ROAM_SCAN_INTERVAL = 60000;  // At most one background scan per minute
+    const int ROAM_RSSI_THRESHOLD = -75;             // dBm; weaker links look for a better AP
+    const int ROAM_HYSTERESIS = 8;                   // dB a candidate must beat the current AP by
+
+    void connectDirect(const WifiNetwork& network, int32_t channel, const uint8_t* bssid);
+    void startScan();
+    void handleScanResult();
+    void handleRoaming();
+    int findBest(int& networkIndex);
+    const WifiNetwork* findNetwork(uint32_t ssidHash);
+    void applyIpConfig(bool useCachedLease);
+    void loadCache();
+    void saveCache();
+    void invalidateCache();
+    uint32_t cacheChecksum(const Cache& cache);
+    static uint32_t ssidHash(const String& ssid);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -11,6 +11,16 @@
 #include "OTAUpdater.h"
 #include "WebsocketLogger.h"
 #include "IrManager.h"
+#include "LogToken.h"
+#include "CrashLog.h"
+#include "TaskRunner.h"
+#include "CommandQueue.h"
+#include "StateReducer.h"
+#include "Profiler.h"
+#include "BootState.h"
+#include "GroupControl.h"
+#include "MqttManager.h"
+#include "DmxReceiver.h"
 // DONT USE PINS
 // D4	GPIO2	Boot Mode Pin & LED. Connected to the onboard LED. Must be floating or pulled HIGH during boot.
 // D8	GPIO15	Boot Mode Pin. Must be pulled LOW for the board to boot normally. Connecting a component that pulls it HIGH will prevent the board from starting.
@@ -34,9 +44,12 @@
 //  SD2, SD3	GPIO9, 10	These are typically connected internally to the ESP8266's flash memory chip and are not exposed or safe to use on most NodeMCU boards.
 
 // --- Project Configuration ---
-// WiFi Credentials
-const char *WIFI_SSID = "JioFiber-4G";
-const char *WIFI_PASSWORD = "Ak@00789101112";
+// WiFi networks live in settings ("networks"); WIFI_DEFAULT_SSID/PASSWORD from secrets.ini seed a fresh device.
+// Optional fixed address. Without it DHCP is used once and the lease is reused on reconnects.
+// const IPAddress WIFI_STATIC_IP(192, 168, 29, 50);
+// const IPAddress WIFI_GATEWAY(192, 168, 29, 1);
+// const IPAddress WIFI_SUBNET(255, 255, 255, 0);
+// const IPAddress WIFI_DNS(192, 168, 29, 1);
 
 // Pin Assignments
 const int INVERTING_LOGIC = true;
@@ -48,151 +61,293 @@ const int MOTION_OFF_HOUR = 6;
 // --- Global Object Instantiation ---
 SettingsManager settingsManager;
 LedController ledController(INVERTING_LOGIC); // true for inverted logic (active-low LEDs)
-WiFiConnector wifiConnector(WIFI_SSID, WIFI_PASSWORD);
+WiFiConnector wifiConnector;
 TimeManager timeManager;
 Scheduler scheduler;
 MDNSManager mdnsManager;
+CrashLog crashLog;
+IrManager irManager(IR_RECEIVER_PIN);
+TaskRunner taskRunner;
+CommandQueue commandQueue;
+StateReducer stateReducer(commandQueue, settingsManager, ledController, scheduler, timeManager, irManager, wifiConnector);
 WebSocketsServer webSocket(81);
 WebsocketLogger websocketLogger(webSocket);
-WebServerController webServerController(80, webSocket, settingsManager, ledController, scheduler, timeManager);
-// MotionSensor motionSensor(MOTION_SENSOR_PIN);
 OTAUpdater otaUpdater;
-IrManager irManager(IR_RECEIVER_PIN);
-
-// --- Timer for non-blocking scheduler check ---
-unsigned long lastSchedulerCheck = 0;
+WebServerController webServerController(80, webSocket, settingsManager, ledController, scheduler, timeManager, mdnsManager, crashLog, irManager, taskRunner, commandQueue, otaUpdater);
+// MotionSensor motionSensor(MOTION_SENSOR_PIN);
+BootState bootState(ledController, timeManager);
+GroupControl groupControl(commandQueue, settingsManager);
+MqttManager mqttManager(commandQueue, settingsManager);
+DmxReceiver dmxReceiver(settingsManager, ledController);
+
+// --- IR hold-to-ramp ---
+const int IR_PRESS_STEP = 10;              // Brightness change for a single press
+const int IR_RAMP_MIN_STEP = 2;            // First steps while a key is held
+const int IR_RAMP_MAX_STEP = 10;           // Step size after holding for a while
+const uint32_t IR_RAMP_DELAY_MS = 300;     // Hold this long before ramping starts
+const uint32_t IR_RAMP_ACCEL_MS = 400;     // Step grows by IR_RAMP_MIN_STEP every interval
+const uint16_t IR_RAMP_TRANSITION_MS = 110; // About one NEC repeat period, keeps the ramp smooth
+bool irRampPendingSave = false;
+
+void handleIrRemote();
+void handleTime();
+void handleSchedule();
+void handleWebSocketCommand(uint8_t num, const char *text, size_t length);
+
+// --- Main loop task periods ---
 const long SCHEDULER_CHECK_INTERVAL = 1000; // Check every second
 
 void setup()
 {
     Serial.begin(115200);
     Log.begin(LOG_LEVEL_VERBOSE, &websocketLogger);
+    LogT.begin(&websocketLogger);
     Log.infoln("\n[Main] Booting device...");
 
+    // 0. Drive the last known outputs before anything slow (settings parsing, WiFi)
+    ledController.begin();
+    bootState.begin();
+
     // 1. Initialize filesystem and load settings
     settingsManager.begin();
     DeviceSettings &settings = settingsManager.getSettings();
 
-    // 2. Initialize LED controller and apply loaded settings
-    ledController.begin();
-    ledController.update(settings);
+    // 1.5. Persist the previous boot's log tail and start mirroring logs
+    crashLog.begin();
+    websocketLogger.setCrashLog(&crashLog);
 
-    // 3. Initialize Scheduler with loaded settings
+    // 2. Initialize Scheduler with loaded settings
     scheduler.updateSchedule(settings);
 
-    // 3.5. Initialize Motion Sensor
+    // 2.5. Initialize Motion Sensor
     // motionSensor.begin();
 
-    // 3.6. Initialize IR Manager
+    // 2.6. Initialize IR Manager
     irManager.begin();
+    irManager.updateBindings(settings);
 
-    // 4. Connect to WiFi (this is a blocking section by design for initial setup)
-    wifiConnector.connect();
-    while (!wifiConnector.isConnected())
+    // 3. Initialize Time Manager; it syncs from the ntp task once WiFi is up
+    timeManager.begin();
+    timeManager.setTimezone(settings.timezone, settings.gmtOffsetSeconds);
+
+    // 4. Apply loaded settings. With a clock restored from RTC the schedule is
+    // evaluated first so scheduled channels don't blink off after a warm reset.
+    ledController.configure(settings);
+    if (timeManager.isTimeValid())
     {
-        wifiConnector.handleConnection(); // Manages status LED and retries
-        // Yield to allow background processes to run
-        yield();
+        handleSchedule();
+        stateReducer.process();
     }
+    ledController.update(settings);
 
-    // 5. Initialize Time Manager and perform initial sync
-    timeManager.begin();
-    timeManager.setTimezone(settings.gmtOffsetSeconds);
-    timeManager.update(); // Force initial update
+    // 5. Connect to WiFi in the background; the wifi task manages retries and the status LED
+    // wifiConnector.setStaticIp(WIFI_STATIC_IP, WIFI_GATEWAY, WIFI_SUBNET, WIFI_DNS);
+    wifiConnector.setNetworks(settings.networks);
+    wifiConnector.connect();
 
     // 6. Initialize mDNS
     const char *MDNS_HOSTNAME = settingsManager.getSettings().mDNSName.c_str(); // mDNS hostname for the device
+    mdnsManager.onRename([](const String &hostname, bool success)
+                         {
+        if (!success)
+            return;
+        // Persist only names that survived conflict probing
+        Command command;
+        command.type = CMD_SET_HOSTNAME;
+        command.text = hostname;
+        command.persist = true;
+        commandQueue.push(command); });
     mdnsManager.begin(MDNS_HOSTNAME);
 
     // 7. Initialize and start the Web Server
     webServerController.begin();
     websocketLogger.begin();
+    websocketLogger.onCommand(handleWebSocketCommand);
 
+    otaUpdater.onRestart([]()
+                         { stateReducer.flush(); });
     otaUpdater.begin(MDNS_HOSTNAME);
     Log.infoln("[OTA] Ready for updates");
 
+    // 8. Register main loop tasks: name, function, period (0 = every pass), time budget
+    taskRunner.add("ota", []()
+                   { otaUpdater.loop(); }, 20, 5000);
+    taskRunner.add("web", []()
+                   { webServerController.handleClient(); }, 0, 20000);
+    taskRunner.add("websocket", []()
+                   { websocketLogger.loop(); }, 0, 10000);
+    taskRunner.add("ir", handleIrRemote, 0, 2000);
+    taskRunner.add("group", []()
+                   { groupControl.loop(); }, 0, 2000);
+    taskRunner.add("mqtt", []()
+                   { mqttManager.loop(); }, 20, 5000);
+    taskRunner.add("dmx", []()
+                   { dmxReceiver.loop(); }, 0, 3000);
+    taskRunner.add("leds", []()
+                   { ledController.loop(); }, 0, 500);
+    taskRunner.add("mdns", []()
+                   { mdnsManager.loop(); }, 100, 5000);
+    taskRunner.add("wifi", []()
+                   { wifiConnector.handleConnection(); }, 250, 2000);
+    taskRunner.add("ntp", handleTime, 20, 2000);
+    taskRunner.add("scheduler", handleSchedule, SCHEDULER_CHECK_INTERVAL, 10000);
+    taskRunner.add("commands", []()
+                   { stateReducer.process(); }, 0, 20000);
+    taskRunner.add("crashlog", []()
+                   { crashLog.loop(); }, 1000, 50000);
+    taskRunner.add("bootstate", []()
+                   { bootState.loop(); }, 1000, 20000);
+
     Log.infoln("[Main] Setup complete. System running.");
 }
 
-void loop()
+// Handle IR remote: dispatch decoded key events and bind learned codes
+void handleIrRemote()
 {
-    // unsigned long loopStartTime = millis();
-
-    // Handle OTA updates
-    ArduinoOTA.handle();
-
-    // Must be called every loop to service web requests
-    webServerController.handleClient();
-    websocketLogger.loop();
-    // Keep mDNS service active
-    mdnsManager.loop();
-
-    // Manages WiFi connection state (e.g., handles reconnects)
-    wifiConnector.handleConnection();
-
-    // Handle IR remote
     irManager.loop();
-    if (irManager.available())
+    IrEvent irEvent;
+    while (irManager.read(irEvent))
     {
-        uint64_t irCode = irManager.read();
-        String irCodeHex = String(irCode, HEX);
-        irCodeHex.toUpperCase();
-        Log.infoln("[Main] IR Code Received: %s", irCodeHex.c_str());
-        String payload = "ir_code:" + irCodeHex;
-        webSocket.broadcastTXT(payload);
+        PROFILE_ZONE("ir.dispatch");
+        uint64_t irCode = irEvent.code;
+        if (irEvent.type == IR_EVENT_PRESS)
+        {
+            char irCodeHex[17];
+            IrManager::formatCode(irCode, irCodeHex);
+            Log.infoln("[Main] IR Code Received: %s", irCodeHex);
+            if (webSocket.connectedClients() > 0)
+            {
+                char payload[26];
+                snprintf(payload, sizeof(payload), "ir_code:%s", irCodeHex);
+                webSocket.broadcastTXT(payload);
+            }
+        }
 
-        DeviceSettings &settings = settingsManager.getSettings();
+        const IrBinding *binding;
+        size_t bindingCount = irManager.lookup(irCode, binding);
 
-        if (irCodeHex == settings.irCodeBrightnessUp)
+        if (irEvent.type == IR_EVENT_RELEASE)
         {
-            Log.infoln("[Main] Brightness Up");
-            for (auto &channel : settings.channels)
+            // A hold only touched RAM and LEDs; persist once now that the key is up
+            if (irRampPendingSave)
             {
-                if (channel.state)
-                {
-                    channel.brightness = min(100, channel.brightness + 10);
-                }
+                irRampPendingSave = false;
+                Command command;
+                command.type = CMD_PERSIST;
+                command.persist = true;
+                commandQueue.push(command);
             }
-            ledController.update(settings);
-            settingsManager.saveSettings();
+            continue;
         }
-        else if (irCodeHex == settings.irCodeBrightnessDown)
+
+        int rampStep = 0;
+        if (irEvent.type == IR_EVENT_REPEAT)
         {
-            Log.infoln("[Main] Brightness Down");
-            for (auto &channel : settings.channels)
+            if (irEvent.holdMs < IR_RAMP_DELAY_MS)
             {
-                if (channel.state)
-                {
-                    channel.brightness = max(0, channel.brightness - 10);
-                }
+                continue;
             }
-            ledController.update(settings);
-            settingsManager.saveSettings();
+            // Accelerate the longer the key is held
+            rampStep = min(IR_RAMP_MAX_STEP, (int)(IR_RAMP_MIN_STEP * (1 + (irEvent.holdMs - IR_RAMP_DELAY_MS) / IR_RAMP_ACCEL_MS)));
         }
-        else
+
+        // Every action bound to the code becomes a command; the reducer applies them together
+        for (size_t i = 0; i < bindingCount; i++, binding++)
         {
-            for (auto &channel : settings.channels)
+            Command command;
+            command.channel = binding->channel;
+            command.transitionMs = IR_RAMP_TRANSITION_MS;
+            switch (binding->action)
             {
-                if (channel.irCode == irCodeHex)
+            case IR_ACTION_BRIGHTNESS_UP:
+            case IR_ACTION_BRIGHTNESS_DOWN:
+            {
+                int step = irEvent.type == IR_EVENT_PRESS ? IR_PRESS_STEP : rampStep;
+                if (irEvent.type == IR_EVENT_PRESS)
+                {
+                    Log.infoln(binding->action == IR_ACTION_BRIGHTNESS_UP ? "[Main] Brightness Up" : "[Main] Brightness Down");
+                }
+                command.type = CMD_ADJUST_BRIGHTNESS;
+                command.value = binding->action == IR_ACTION_BRIGHTNESS_UP ? step : -step;
+                irRampPendingSave = true;
+                commandQueue.push(command);
+                break;
+            }
+            case IR_ACTION_TOGGLE_CHANNEL:
+                // Holding a toggle key must not flip the channel again
+                if (irEvent.type == IR_EVENT_PRESS)
                 {
-                    Log.infoln("[Main] Toggling channel %s", channel.channelName.c_str());
-                    channel.state = !channel.state;
-                    ledController.update(settings);
-                    settingsManager.saveSettings();
-                    break; // Assuming one IR code per channel
+                    command.type = CMD_TOGGLE_CHANNEL;
+                    command.persist = true;
+                    commandQueue.push(command);
                 }
+                break;
+            case IR_ACTION_RECALL_SCENE:
+                if (irEvent.type == IR_EVENT_PRESS)
+                {
+                    command.type = CMD_RECALL_SCENE;
+                    command.value = binding->channel;
+                    command.transitionMs = SCENE_FADE_MS;
+                    command.persist = true;
+                    commandQueue.push(command);
+                }
+                break;
             }
         }
     }
 
-    // Periodically update time from NTP server
+    // Bind a code captured in learn mode straight into the settings
+    IrLearnResult learned;
+    if (irManager.takeLearnResult(learned))
+    {
+        Command command;
+        command.type = CMD_BIND_IR_CODE;
+        command.value = learned.action;
+        command.channel = learned.channel;
+        command.code = learned.code;
+        command.persist = true;
+        commandQueue.push(command);
+
+        char irCodeHex[17];
+        IrManager::formatCode(learned.code, irCodeHex);
+        char payload[48];
+        snprintf(payload, sizeof(payload), "ir_learned:%d:%d:%s", learned.action, learned.channel, irCodeHex);
+        webSocket.broadcastTXT(payload);
+    }
+}
+
+// Handle WebSocket text commands: "scene:<name>" recalls a scene
+void handleWebSocketCommand(uint8_t num, const char *text, size_t length)
+{
+    if (length <= 6 || strncmp(text, "scene:", 6) != 0)
+        return;
+    int scene = settingsManager.findScene(String(text + 6));
+    if (scene < 0)
+    {
+        webSocket.sendTXT(num, "scene_error:unknown scene");
+        return;
+    }
+    Command command;
+    command.type = CMD_RECALL_SCENE;
+    command.value = scene;
+    command.transitionMs = SCENE_FADE_MS;
+    command.persist = true;
+    commandQueue.push(command);
+}
+
+void handleTime()
+{
+    // Steps the SNTP state machine; polled often so the reply is timestamped promptly
     if (wifiConnector.isConnected())
     {
         timeManager.update();
     }
+}
 
+void handleSchedule()
+{
     // Motion detection logic
-    int currentHour = timeManager.getHours();
+    // int currentHour = timeManager.getHours();
     // if (motionSensor.motionDetected() && (currentHour >= MOTION_ON_HOUR || currentHour < MOTION_OFF_HOUR))
     // {
     //     Log.infoln("[Main] Motion detected at night. Turning on lights.");
@@ -232,47 +387,52 @@ void loop()
     // }
     // else
     // {
-    // Check the scheduler periodically (non-blocking)
-    if (millis() - lastSchedulerCheck > SCHEDULER_CHECK_INTERVAL)
+    // Check the scheduler (runs every SCHEDULER_CHECK_INTERVAL via the task runner).
+    // Needs a clock, not WiFi: one restored after a warm reset is good enough.
+    if (timeManager.isTimeValid())
     {
-        lastSchedulerCheck = millis();
+        DeviceSettings &settings = settingsManager.getSettings();
+        std::vector<SchedulerAction> actions = scheduler.checkSchedule(
+            timeManager.getHours(),
+            timeManager.getMinutes());
 
-        if (wifiConnector.isConnected())
+        for (const auto &action : actions)
         {
-            DeviceSettings &settings = settingsManager.getSettings();
-            std::vector<SchedulerAction> actions = scheduler.checkSchedule(
-                timeManager.getHours(),
-                timeManager.getMinutes());
-
-            bool settingsChanged = false;
-
-            for (const auto &action : actions)
+            Log.infoln("[Main] Scheduler Action: Channel: %s, State: %s, Brightness: %d\n",
+                       action.channel.c_str(),
+                       action.stateOnOFF ? "ON" : "OFF",
+                       action.brightness);
+            // Hand the action to the reducer, which updates the LEDs only on an actual change
+            for (size_t i = 0; i < settings.channels.size(); i++)
             {
-                Log.infoln("[Main] Scheduler Action: Channel: %s, State: %s, Brightness: %d\n",
-                           action.channel.c_str(),
-                           action.stateOnOFF ? "ON" : "OFF",
-                           action.brightness);
-                // Update the LED controller based on the action
-
-                for (auto &channel : settings.channels)
-                {
-                    if (channel.pin == action.channel)
-                    {
-                        if (channel.scheduleEnabled && action.stateOnOFF)
-                            channel.schedulerActive = true;
-                        else
-                            channel.schedulerActive = false;
-                        settingsChanged = true;
-                    }
-                }
-                if (settingsChanged)
+                const ChannelSetting &channel = settings.channels[i];
+                if (channel.pin == action.channel)
                 {
-                    ledController.update(settings);
+                    Command command;
+                    command.type = CMD_SCHEDULER_ACTIVE;
+                    command.channel = i;
+                    command.state = channel.scheduleEnabled && action.stateOnOFF;
+                    commandQueue.push(command);
                 }
             }
         }
+
+        int scene = scheduler.checkScenes(timeManager.getHours(), timeManager.getMinutes());
+        if (scene >= 0)
+        {
+            Command command;
+            command.type = CMD_RECALL_SCENE;
+            command.value = scene;
+            command.transitionMs = SCENE_FADE_MS;
+            command.persist = true;
+            commandQueue.push(command);
+        }
     }
     //}
+}
 
-    // Log.verboseln("[Main] Loop duration: %lu ms", millis() - loopStartTime);
-}
\ No newline at end of file
+void loop()
+{
+    // Every subsystem runs from the task runner at its own period and budget
+    taskRunner.run();
+}
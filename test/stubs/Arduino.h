@@ -0,0 +1,62 @@
+#ifndef ARDUINO_STUB_H
+#define ARDUINO_STUB_H
+
+// Host stand-in for the parts of the ESP8266 Arduino core that the code
+// under test (see build_src_filter in [env:native]) uses.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define IRAM_ATTR
+#define OUTPUT 0x01
+#define SDA 4
+#define SCL 5
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void delayMicroseconds(unsigned int) {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+struct EspClass
+{
+    uint32_t getCycleCount() { return 0; }
+};
+inline EspClass ESP;
+
+// GPIO output registers, modelled as one word of pin levels; bit 16 is GPIO16
+inline uint32_t stubGpioOut = 0;
+
+struct StubSetRegister
+{
+    void operator=(uint32_t mask) { stubGpioOut |= mask & 0xFFFF; }
+};
+struct StubClearRegister
+{
+    void operator=(uint32_t mask) { stubGpioOut &= ~(mask & 0xFFFF); }
+};
+struct StubGpio16Register
+{
+    void operator=(uint32_t value) { stubGpioOut = (value & 1) ? stubGpioOut | 0x10000 : stubGpioOut & ~0x10000UL; }
+};
+inline StubSetRegister GPOS;
+inline StubClearRegister GPOC;
+inline StubGpio16Register GP16O;
+
+// timer1: tests call stubTimer1Isr to fire the interrupt after stubTimer1Ticks
+#define TIM_DIV16 1
+#define TIM_EDGE 0
+#define TIM_SINGLE 0
+
+typedef void (*timercallback)(void);
+inline timercallback stubTimer1Isr = nullptr;
+inline uint32_t stubTimer1Ticks = 0;
+
+inline void timer1_attachInterrupt(timercallback isr) { stubTimer1Isr = isr; }
+inline void timer1_detachInterrupt() { stubTimer1Isr = nullptr; }
+inline void timer1_enable(uint8_t, uint8_t, uint8_t) {}
+inline void timer1_disable() {}
+inline void timer1_write(uint32_t ticks) { stubTimer1Ticks = ticks; }
+
+#endif // ARDUINO_STUB_H
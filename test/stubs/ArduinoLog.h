@@ -0,0 +1,18 @@
+#ifndef ARDUINO_LOG_STUB_H
+#define ARDUINO_LOG_STUB_H
+
+// Host stand-in for ArduinoLog; tests check behaviour, not log output
+
+class Logging
+{
+public:
+    template <typename... Args>
+    void infoln(Args...) {}
+    template <typename... Args>
+    void warningln(Args...) {}
+    template <typename... Args>
+    void errorln(Args...) {}
+};
+inline Logging Log;
+
+#endif // ARDUINO_LOG_STUB_H
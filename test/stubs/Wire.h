@@ -0,0 +1,41 @@
+#ifndef WIRE_STUB_H
+#define WIRE_STUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/**
+ * Host stand-in for the Wire library: an I2C bus that records every
+ * transmission, so tests can check the exact bytes a driver sends.
+ */
+class TwoWire
+{
+public:
+    struct Transmission
+    {
+        uint8_t address;
+        std::vector<uint8_t> bytes;
+    };
+
+    std::vector<Transmission> transmissions;
+    uint8_t result = 0; // What endTransmission() returns; 0 is an ACK, 2 a NACK on the address
+
+    void begin(int, int) {}
+    void setClock(uint32_t) {}
+    void beginTransmission(uint8_t address) { transmissions.push_back({address, {}}); }
+    size_t write(uint8_t value)
+    {
+        transmissions.back().bytes.push_back(value);
+        return 1;
+    }
+    size_t write(const uint8_t *data, size_t length)
+    {
+        transmissions.back().bytes.insert(transmissions.back().bytes.end(), data, data + length);
+        return length;
+    }
+    uint8_t endTransmission() { return result; }
+};
+inline TwoWire Wire;
+
+#endif // WIRE_STUB_H
@@ -0,0 +1,232 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string>
+#include "GzipInflater.h"
+#include "vectors.h"
+
+static GzipInflater inflater;
+static std::string output;
+
+// The text the vectors in vectors.h were compressed from
+static std::string sampleText(int lines)
+{
+    std::string text;
+    char line[64];
+    for (int i = 0; i < lines; i++)
+    {
+        snprintf(line, sizeof(line), "%d: the quick brown fox jumps over %d lazy dogs\n", i, (i * 7919) % 1000);
+        text += line;
+    }
+    return text;
+}
+
+static uint32_t crc32(const std::string &data)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (unsigned char c : data)
+    {
+        crc ^= c;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320 : 0);
+    }
+    return ~crc;
+}
+
+static void putLe(std::string &stream, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        stream += (char)(value >> (8 * i));
+}
+
+// What level 0 produces: a gzip header, stored blocks of at most blockSize bytes, the trailer
+static std::string storedGzip(const std::string &data, size_t blockSize)
+{
+    std::string stream("\x1F\x8B\x08\x00\x00\x00\x00\x00\x00\x03", 10);
+    size_t pos = 0;
+    do
+    {
+        size_t length = data.size() - pos < blockSize ? data.size() - pos : blockSize;
+        stream += (char)(pos + length == data.size() ? 1 : 0); // BFINAL, BTYPE 00
+        putLe(stream, length, 2);
+        putLe(stream, ~length & 0xFFFF, 2);
+        stream.append(data, pos, length);
+        pos += length;
+    } while (pos < data.size());
+    putLe(stream, crc32(data), 4);
+    putLe(stream, data.size(), 4);
+    return stream;
+}
+
+// Feeds the stream in chunks of chunkSize bytes; true if every write and end() succeeded
+static bool inflate(const uint8_t *data, size_t length, size_t chunkSize)
+{
+    if (!inflater.begin([](const uint8_t *out, size_t outLength)
+                        {
+                            output.append((const char *)out, outLength);
+                            return true; }))
+        return false;
+    for (size_t pos = 0; pos < length; pos += chunkSize)
+    {
+        if (!inflater.write(data + pos, length - pos < chunkSize ? length - pos : chunkSize))
+            return false;
+    }
+    return inflater.end();
+}
+
+static bool inflate(const std::string &stream, size_t chunkSize)
+{
+    return inflate((const uint8_t *)stream.data(), stream.size(), chunkSize);
+}
+
+void setUp()
+{
+    output.clear();
+}
+
+void tearDown() {}
+
+void test_stored_blocks()
+{
+    std::string text = sampleText(60);
+    TEST_ASSERT_TRUE(inflate(storedGzip(text, 1000), 512));
+    TEST_ASSERT_TRUE(text == output);
+    TEST_ASSERT_EQUAL_UINT32(text.size(), inflater.getOutputSize());
+}
+
+void test_empty_stored_block()
+{
+    TEST_ASSERT_TRUE(inflate(storedGzip("", 1000), 512));
+    TEST_ASSERT_EQUAL_UINT32(0, output.size());
+}
+
+void test_fixed_block()
+{
+    TEST_ASSERT_TRUE(inflate(FIXED_GZIP, sizeof(FIXED_GZIP), sizeof(FIXED_GZIP)));
+    TEST_ASSERT_TRUE(sampleText(10) == output);
+}
+
+void test_dynamic_blocks()
+{
+    TEST_ASSERT_TRUE(inflate(DYNAMIC_GZIP, sizeof(DYNAMIC_GZIP), 1460));
+    TEST_ASSERT_TRUE(sampleText(300) == output);
+}
+
+void test_byte_at_a_time()
+{
+    TEST_ASSERT_TRUE(inflate(DYNAMIC_GZIP, sizeof(DYNAMIC_GZIP), 1));
+    TEST_ASSERT_TRUE(sampleText(300) == output);
+
+    output.clear();
+    std::string text = sampleText(40);
+    TEST_ASSERT_TRUE(inflate(storedGzip(text, 300), 1));
+    TEST_ASSERT_TRUE(text == output);
+}
+
+void test_odd_chunk_sizes()
+{
+    const size_t sizes[] = {7, 599, 600, 1023, 1025};
+    for (size_t size : sizes)
+    {
+        output.clear();
+        TEST_ASSERT_TRUE(inflate(DYNAMIC_GZIP, sizeof(DYNAMIC_GZIP), size));
+        TEST_ASSERT_TRUE(sampleText(300) == output);
+    }
+}
+
+void test_crc_mismatch()
+{
+    std::string stream((const char *)DYNAMIC_GZIP, sizeof(DYNAMIC_GZIP));
+    stream[stream.size() - 8] ^= 0x01;
+    TEST_ASSERT_FALSE(inflate(stream, 1460));
+    TEST_ASSERT_EQUAL_STRING("CRC mismatch", inflater.getError());
+}
+
+void test_length_mismatch()
+{
+    std::string stream((const char *)DYNAMIC_GZIP, sizeof(DYNAMIC_GZIP));
+    stream[stream.size() - 4] ^= 0x01;
+    TEST_ASSERT_FALSE(inflate(stream, 1460));
+    TEST_ASSERT_EQUAL_STRING("length mismatch", inflater.getError());
+}
+
+void test_truncated_stream()
+{
+    // Cut inside the trailer, inside the compressed data and inside the header
+    const size_t lengths[] = {sizeof(DYNAMIC_GZIP) - 3, sizeof(DYNAMIC_GZIP) / 2, 5};
+    for (size_t length : lengths)
+    {
+        output.clear();
+        TEST_ASSERT_FALSE(inflate(DYNAMIC_GZIP, length, 1460));
+        TEST_ASSERT_NOT_NULL(inflater.getError());
+    }
+}
+
+void test_corrupt_stored_length()
+{
+    std::string stream = storedGzip(sampleText(5), 1000);
+    stream[13] ^= 0x01; // NLEN no longer matches LEN
+    TEST_ASSERT_FALSE(inflate(stream, 512));
+    TEST_ASSERT_EQUAL_STRING("corrupt stored block", inflater.getError());
+}
+
+void test_match_at_window_size()
+{
+    TEST_ASSERT_TRUE(inflate(NEAR_MATCH_GZIP, sizeof(NEAR_MATCH_GZIP), sizeof(NEAR_MATCH_GZIP)));
+    TEST_ASSERT_TRUE(std::string(4132, 'a') == output);
+}
+
+void test_match_past_window_is_rejected()
+{
+    TEST_ASSERT_FALSE(inflate(FAR_MATCH_GZIP, sizeof(FAR_MATCH_GZIP), sizeof(FAR_MATCH_GZIP)));
+    TEST_ASSERT_EQUAL_STRING("window too large, compress with tools/ota.py", inflater.getError());
+}
+
+void test_output_rejected()
+{
+    inflater.begin([](const uint8_t *, size_t)
+                   { return false; });
+    TEST_ASSERT_TRUE(inflater.write(DYNAMIC_GZIP, 100)); // Still below the input margin, nothing decoded
+    TEST_ASSERT_FALSE(inflater.write(DYNAMIC_GZIP + 100, sizeof(DYNAMIC_GZIP) - 100));
+    TEST_ASSERT_EQUAL_STRING("output rejected", inflater.getError());
+}
+
+void test_is_gzip()
+{
+    const uint8_t gzip[] = {0x1F, 0x8B, 0x08};
+    const uint8_t otherMethod[] = {0x1F, 0x8B, 0x07};
+    const uint8_t firmware[] = {0xE9, 0x03, 0x02};
+    const uint8_t magicOnly[] = {0x1F, 0x00, 0x08};
+    TEST_ASSERT_TRUE(GzipInflater::isGzip(gzip, 3));
+    TEST_ASSERT_FALSE(GzipInflater::isGzip(gzip, 2));
+    TEST_ASSERT_FALSE(GzipInflater::isGzip(otherMethod, 3));
+    TEST_ASSERT_FALSE(GzipInflater::isGzip(firmware, 3));
+    TEST_ASSERT_FALSE(GzipInflater::isGzip(magicOnly, 3));
+}
+
+void test_not_gzip()
+{
+    const uint8_t firmware[] = {0xE9, 0x03, 0x02, 0x40, 0x00, 0x00, 0x10, 0x40};
+    TEST_ASSERT_FALSE(inflate(firmware, sizeof(firmware), sizeof(firmware)));
+    TEST_ASSERT_EQUAL_STRING("not a gzip stream", inflater.getError());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_stored_blocks);
+    RUN_TEST(test_empty_stored_block);
+    RUN_TEST(test_fixed_block);
+    RUN_TEST(test_dynamic_blocks);
+    RUN_TEST(test_byte_at_a_time);
+    RUN_TEST(test_odd_chunk_sizes);
+    RUN_TEST(test_crc_mismatch);
+    RUN_TEST(test_length_mismatch);
+    RUN_TEST(test_truncated_stream);
+    RUN_TEST(test_corrupt_stored_length);
+    RUN_TEST(test_match_at_window_size);
+    RUN_TEST(test_match_past_window_is_rejected);
+    RUN_TEST(test_output_rejected);
+    RUN_TEST(test_is_gzip);
+    RUN_TEST(test_not_gzip);
+    return UNITY_END();
+}
@@ -0,0 +1,140 @@
+#ifndef GZIP_VECTORS_H
+#define GZIP_VECTORS_H
+
+#include <stdint.h>
+
+// Compressed with Python's zlib at level 9 and wbits 12, like tools/ota.py.
+// The plain text is sampleText() in test_main.cpp.
+
+// sampleText(10), Z_FIXED strategy: one fixed Huffman block
+static const uint8_t FIXED_GZIP[] = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x33, 0xB0, 0x52, 0x28, 0xC9, 0x48,
+    0x55, 0x28, 0x2C, 0xCD, 0x4C, 0xCE, 0x56, 0x48, 0x2A, 0xCA, 0x2F, 0xCF, 0x53, 0x48, 0xCB, 0xAF,
+    0x50, 0xC8, 0x2A, 0xCD, 0x2D, 0x28, 0x56, 0xC8, 0x2F, 0x4B, 0x2D, 0x52, 0x30, 0x50, 0xC8, 0x49,
+    0xAC, 0xAA, 0x54, 0x48, 0xC9, 0x4F, 0x2F, 0xE6, 0x32, 0x24, 0xA8, 0xDA, 0xD2, 0xD0, 0x12, 0x49,
+    0xBD, 0x11, 0x41, 0xF5, 0x16, 0xC6, 0x16, 0x48, 0xEA, 0x8D, 0x09, 0xAA, 0x37, 0x37, 0x35, 0x47,
+    0x52, 0x6F, 0x42, 0x50, 0xBD, 0x99, 0xB9, 0x19, 0x92, 0x7A, 0x53, 0x82, 0xEA, 0x4D, 0x2D, 0x4D,
+    0x91, 0xD4, 0x9B, 0x11, 0x56, 0x6F, 0x68, 0x82, 0xA4, 0xDE, 0x9C, 0xA0, 0x7A, 0x13, 0x63, 0x63,
+    0x24, 0xF5, 0x16, 0x04, 0xD5, 0x1B, 0x9B, 0x1A, 0x21, 0xA9, 0xB7, 0x24, 0xA8, 0xDE, 0xC8, 0xDC,
+    0x10, 0x49, 0x3D, 0x00, 0xA6, 0x3A, 0xB7, 0x99, 0xDE, 0x01, 0x00, 0x00,
+};
+
+// sampleText(300): dynamic Huffman blocks
+static const uint8_t DYNAMIC_GZIP[] = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8D, 0xD7, 0x49, 0xB2, 0x2D, 0x47,
+    0x11, 0x84, 0xE1, 0xB9, 0x56, 0x71, 0x96, 0x90, 0xD1, 0x47, 0xB0, 0x1B, 0xD4, 0xD1, 0x09, 0x1E,
+    0xA8, 0x05, 0xAD, 0x1E, 0x0D, 0xC3, 0x47, 0xE1, 0xF3, 0x4C, 0xBB, 0xD7, 0xEC, 0x3B, 0x55, 0xFE,
+    0xD7, 0xFB, 0xD3, 0xE7, 0xE7, 0xBF, 0x7E, 0xF7, 0xF9, 0xCF, 0x2F, 0x7F, 0xFB, 0xE6, 0x1F, 0x9F,
+    0xAF, 0x7F, 0xFC, 0xF2, 0xDB, 0xBF, 0x3E, 0xDF, 0x7F, 0xF9, 0xEF, 0xE7, 0xEF, 0xBF, 0xFC, 0xF3,
+    0xDF, 0x3F, 0x7D, 0xBE, 0xFC, 0xFA, 0xDD, 0x8F, 0x9F, 0xF7, 0xF9, 0xE1, 0xCF, 0xBF, 0xFF, 0xEF,
+    0xF3, 0xED, 0x97, 0xBF, 0xFC, 0xF4, 0x95, 0x9C, 0xA7, 0x47, 0x66, 0x9D, 0xD7, 0xF3, 0x7C, 0x5B,
+    0xAF, 0xF3, 0x76, 0x9E, 0xAF, 0xA8, 0x75, 0xDE, 0xCF, 0xF3, 0x59, 0xB9, 0xCE, 0xC7, 0x79, 0x3E,
+    0x26, 0xD6, 0xF9, 0xBC, 0xCF, 0x8B, 0xAF, 0xF3, 0x75, 0x9E, 0x77, 0xB3, 0x75, 0xBE, 0xCF, 0xF3,
+    0x16, 0xBA, 0xCE, 0xCF, 0x79, 0x5E, 0x4B, 0xB6, 0xD7, 0x3B, 0x2F, 0xC8, 0x00, 0xF0, 0x2D, 0x2C,
+    0x6F, 0x0B, 0xCB, 0x4D, 0xAC, 0x5B, 0x58, 0x6E, 0xE2, 0xF1, 0x4D, 0x2C, 0xB7, 0x71, 0xE7, 0x36,
+    0x96, 0x1B, 0xB9, 0x7A, 0x23, 0xCB, 0xAD, 0x5C, 0x6F, 0x2B, 0xCB, 0xCD, 0x9C, 0xBA, 0x99, 0xE5,
+    0x76, 0x0E, 0xDF, 0xCE, 0x72, 0x43, 0x7B, 0x6E, 0x68, 0xBD, 0xA1, 0xAD, 0x37, 0xB4, 0xDE, 0xD0,
+    0x3A, 0xF0, 0x28, 0x13, 0xD0, 0xB2, 0xA5, 0xF5, 0x96, 0x16, 0xDB, 0xD2, 0x7A, 0x4B, 0xC7, 0x86,
+    0xD6, 0x1B, 0x7A, 0x6A, 0x43, 0xEB, 0x0D, 0xDD, 0xB3, 0xA1, 0xF5, 0x86, 0x6E, 0xD9, 0xD0, 0x7A,
+    0x43, 0x97, 0x6D, 0x68, 0xBD, 0xA1, 0x33, 0x36, 0xB4, 0xDD, 0xD0, 0x51, 0x1B, 0xDA, 0x6E, 0x68,
+    0xEF, 0x0D, 0x6D, 0x37, 0xB4, 0x3F, 0x78, 0x69, 0xDF, 0xD0, 0xA6, 0x1B, 0xDA, 0x6E, 0x68, 0xF5,
+    0x2D, 0x6D, 0xB7, 0xB4, 0xE4, 0x96, 0x36, 0x42, 0x7A, 0x43, 0xDB, 0x0D, 0xBD, 0x99, 0xED, 0x66,
+    0x1E, 0xDD, 0xCC, 0x36, 0xC4, 0xFF, 0xB3, 0x99, 0xFD, 0x66, 0xAE, 0xDC, 0xCC, 0x2E, 0xC4, 0x14,
+    0x6E, 0x66, 0x57, 0x62, 0x0B, 0x37, 0xB3, 0x1B, 0x31, 0x86, 0x30, 0xCE, 0x4E, 0xAC, 0xE1, 0x66,
+    0xF6, 0x20, 0xE6, 0x70, 0x33, 0x7B, 0x12, 0x7B, 0xB8, 0x9D, 0xBD, 0x88, 0x3D, 0xDC, 0xD2, 0x7E,
+    0x4B, 0x8B, 0x6C, 0x69, 0xBF, 0xA5, 0x6D, 0x43, 0xC7, 0x0D, 0x3D, 0xB1, 0xA1, 0x43, 0x88, 0x3D,
+    0xDC, 0xD0, 0xA1, 0xC4, 0x1E, 0x6E, 0xE8, 0x20, 0x2A, 0xEC, 0x6D, 0xE8, 0x20, 0x32, 0x4C, 0x21,
+    0xC3, 0x88, 0x0E, 0xF3, 0x0D, 0x1D, 0x49, 0xEC, 0xE1, 0x86, 0x0E, 0xE2, 0x81, 0xEE, 0x0D, 0x1D,
+    0x44, 0x8A, 0xBD, 0x0D, 0x1D, 0x44, 0x8B, 0xE9, 0x96, 0x4E, 0xA2, 0xC5, 0x7C, 0x4B, 0xA7, 0x10,
+    0x4F, 0xE8, 0x3E, 0xAF, 0xC4, 0x1E, 0x6E, 0xE8, 0x34, 0x62, 0x0F, 0x37, 0x74, 0x12, 0x2D, 0x26,
+    0x1B, 0x3A, 0x89, 0x16, 0x33, 0x08, 0xEE, 0x24, 0xF6, 0x70, 0x43, 0x67, 0x11, 0x7B, 0xB8, 0xA1,
+    0xF3, 0x86, 0xF6, 0xD9, 0xD0, 0x49, 0xB4, 0x98, 0x6C, 0xE8, 0x22, 0x5A, 0xCC, 0x36, 0x74, 0x11,
+    0x2D, 0xE6, 0x5B, 0xBA, 0x94, 0xD8, 0xC3, 0x2D, 0x5D, 0x84, 0xF4, 0x86, 0x2E, 0xE2, 0x89, 0xDE,
+    0xC7, 0x89, 0x12, 0xD3, 0xCD, 0x5C, 0xCC, 0x3E, 0xC3, 0x87, 0x55, 0x11, 0x7B, 0xB8, 0x99, 0xEB,
+    0x66, 0xCE, 0xDE, 0xCC, 0x45, 0x94, 0xD8, 0xDB, 0xCC, 0x4D, 0x94, 0x98, 0x6E, 0xE6, 0x26, 0x4A,
+    0xCC, 0x36, 0x73, 0x2B, 0xB1, 0x87, 0x9B, 0xB9, 0x8D, 0xD8, 0xC3, 0xED, 0xDC, 0x4E, 0xEC, 0xE1,
+    0x96, 0x6E, 0xA2, 0xC4, 0x64, 0x4B, 0xF7, 0x2D, 0x6D, 0x1B, 0xBA, 0x8B, 0xD8, 0xC3, 0x0D, 0xDD,
+    0x4D, 0xFC, 0xB4, 0x37, 0x74, 0xDF, 0xD0, 0x35, 0x1B, 0x7A, 0x88, 0x16, 0x93, 0x0D, 0x3D, 0x44,
+    0x8B, 0xE9, 0x86, 0x1E, 0xA2, 0xC5, 0x7C, 0x43, 0x8F, 0x11, 0x7B, 0xB8, 0xA1, 0xC7, 0x89, 0x3D,
+    0xDC, 0xD0, 0x43, 0xB4, 0xD8, 0xDB, 0xD0, 0x43, 0xB4, 0x98, 0x6E, 0xE9, 0x21, 0x5A, 0xCC, 0xB7,
+    0xF4, 0x10, 0x8F, 0xF4, 0x86, 0x9E, 0x1B, 0x7A, 0x7A, 0x43, 0xCB, 0x23, 0x62, 0xEC, 0x3D, 0xB8,
+    0x41, 0xD4, 0x98, 0x0C, 0xDC, 0x20, 0x72, 0xCC, 0x1A, 0x6E, 0x18, 0xB1, 0x89, 0x05, 0x37, 0x9C,
+    0x18, 0xC5, 0x84, 0x1B, 0x41, 0xAC, 0x62, 0xC0, 0x0D, 0x22, 0xC9, 0xC4, 0xE1, 0x06, 0xD1, 0x64,
+    0x66, 0x70, 0xE3, 0x16, 0xD7, 0x50, 0xB8, 0x71, 0x9B, 0x4B, 0x81, 0xB9, 0x30, 0xE6, 0x70, 0xE1,
+    0x26, 0x07, 0x70, 0x21, 0xB2, 0x4C, 0x01, 0x5C, 0x88, 0xB5, 0x76, 0x00, 0x17, 0x27, 0xE6, 0x11,
+    0xC0, 0x25, 0x88, 0x7D, 0x04, 0x70, 0x21, 0xD2, 0xEC, 0x01, 0xB8, 0x10, 0x6D, 0xA6, 0x00, 0x2E,
+    0x44, 0x9C, 0x39, 0x80, 0x0B, 0xF1, 0xBD, 0x95, 0x00, 0xAE, 0x37, 0xB8, 0x36, 0x88, 0xAB, 0x10,
+    0x2B, 0x09, 0xE6, 0x4A, 0x04, 0x9A, 0x80, 0xB9, 0xDE, 0xE6, 0x06, 0xE4, 0xEA, 0xC4, 0x50, 0x02,
+    0xB9, 0x06, 0xB1, 0x94, 0x40, 0xAE, 0x49, 0x4C, 0x25, 0x90, 0x2B, 0xD1, 0x69, 0x02, 0xE4, 0x4A,
+    0xBC, 0xD5, 0x0D, 0xC8, 0xF5, 0x26, 0x8F, 0x00, 0x72, 0xBB, 0xC9, 0xBD, 0x80, 0xDC, 0x84, 0xD8,
+    0x4B, 0x20, 0x37, 0x22, 0xD6, 0x1E, 0x90, 0x1B, 0x51, 0x6B, 0x0A, 0xE6, 0x46, 0xE4, 0x9A, 0x83,
+    0xB9, 0x11, 0x8F, 0x39, 0x90, 0x5B, 0x12, 0xA3, 0x09, 0xE4, 0x46, 0x14, 0xDB, 0x03, 0x72, 0x23,
+    0x92, 0x4D, 0x81, 0xDC, 0x88, 0x66, 0x73, 0x20, 0xF7, 0x9B, 0x3C, 0x13, 0xC8, 0x5D, 0x88, 0xD1,
+    0x04, 0x72, 0x57, 0x62, 0x34, 0x81, 0xDC, 0x89, 0x6E, 0x13, 0x20, 0x77, 0x22, 0xDC, 0x0C, 0xC8,
+    0x3D, 0x88, 0xD1, 0x04, 0x73, 0x4F, 0x62, 0x34, 0xC1, 0xDC, 0x09, 0x73, 0x20, 0xF7, 0x9B, 0x5C,
+    0x40, 0xDC, 0x89, 0x78, 0x33, 0x10, 0x8F, 0x5B, 0xBC, 0x03, 0xC4, 0x43, 0x88, 0xD5, 0x04, 0xF1,
+    0x50, 0x62, 0x35, 0x41, 0x3C, 0x88, 0x78, 0x7B, 0x20, 0x1E, 0x44, 0xBC, 0x29, 0x88, 0x07, 0x11,
+    0x6F, 0x0E, 0xE2, 0x41, 0x7C, 0x95, 0x25, 0x88, 0x47, 0x11, 0xAB, 0x09, 0xE4, 0x41, 0xC4, 0xDB,
+    0x03, 0xF3, 0x20, 0xE2, 0x4D, 0xC1, 0x3C, 0x89, 0x17, 0x3B, 0x90, 0x27, 0x11, 0x6F, 0x01, 0xE4,
+    0xA9, 0xC4, 0x6A, 0x02, 0x79, 0x1A, 0xB1, 0x9A, 0x40, 0x9E, 0x44, 0xBE, 0x09, 0x90, 0x27, 0xF1,
+    0x5E, 0x37, 0x20, 0xCF, 0x24, 0x56, 0x13, 0xC8, 0xB3, 0x88, 0xD5, 0x04, 0xF2, 0xBC, 0xC9, 0x6D,
+    0x80, 0x3C, 0x89, 0x7C, 0x13, 0x20, 0x2F, 0x22, 0xDF, 0x0C, 0xCC, 0x8B, 0xC8, 0x37, 0x07, 0xF3,
+    0x62, 0x1E, 0x73, 0xB8, 0x60, 0xC4, 0x6A, 0x02, 0x79, 0x11, 0xF9, 0xF6, 0x80, 0xBC, 0x88, 0x7C,
+    0x53, 0x20, 0x2F, 0x22, 0xDF, 0x1C, 0xC8, 0xAB, 0x88, 0xD5, 0x04, 0xF2, 0xBA, 0xC9, 0xA3, 0x81,
+    0xBC, 0x88, 0x7C, 0x7B, 0x40, 0xDE, 0xC4, 0x53, 0xAE, 0x40, 0xDE, 0x44, 0xBE, 0x19, 0x90, 0xB7,
+    0x12, 0xAB, 0x09, 0xE6, 0x6D, 0xC4, 0x6A, 0x82, 0x79, 0x13, 0xE6, 0x40, 0xDE, 0x37, 0xB9, 0x80,
+    0x78, 0x13, 0xF5, 0x66, 0x20, 0xDE, 0x45, 0xAC, 0x26, 0x88, 0xF7, 0x2D, 0x5E, 0x05, 0xE2, 0x7D,
+    0x8B, 0xE7, 0x80, 0xF8, 0x10, 0xF5, 0x26, 0x20, 0x3E, 0x44, 0xBD, 0x29, 0x88, 0x0F, 0x51, 0x6F,
+    0x0E, 0xE2, 0x43, 0x7C, 0xA3, 0x25, 0x88, 0x8F, 0x13, 0xAB, 0x09, 0xE4, 0x43, 0xD4, 0xDB, 0x03,
+    0xF3, 0x21, 0xEA, 0x4D, 0xC1, 0x7C, 0x88, 0x17, 0x3B, 0x90, 0x4F, 0x13, 0x3F, 0x5C, 0x20, 0x9F,
+    0x9B, 0xBC, 0x7B, 0x93, 0xEB, 0x23, 0xF2, 0xED, 0x3D, 0xB8, 0x41, 0xE4, 0x9B, 0x0C, 0xDC, 0x20,
+    0xDE, 0xEB, 0xD6, 0x70, 0xC3, 0x88, 0xD5, 0x2C, 0xB8, 0xE1, 0xC4, 0x6A, 0x26, 0xDC, 0x08, 0x62,
+    0x35, 0x03, 0x6E, 0x10, 0xF9, 0x26, 0x0E, 0x37, 0x88, 0x7C, 0x33, 0x83, 0x1B, 0x44, 0xB1, 0x87,
+    0xC2, 0x0D, 0xE2, 0x23, 0x0D, 0xC8, 0xE5, 0x26, 0x9F, 0x01, 0x72, 0x21, 0xF2, 0xED, 0x01, 0xB9,
+    0x10, 0xF9, 0xA6, 0x40, 0x2E, 0x44, 0xBE, 0x39, 0x90, 0x8B, 0x13, 0xAB, 0x09, 0xE4, 0x12, 0xC4,
+    0x6A, 0x02, 0xB9, 0x10, 0xF9, 0xF6, 0x80, 0x5C, 0x88, 0xA7, 0x5C, 0x81, 0x5C, 0x88, 0x7C, 0x73,
+    0x20, 0x97, 0x9B, 0x5C, 0x13, 0xCC, 0xF5, 0x36, 0xFF, 0x63, 0xEF, 0xE1, 0x06, 0x61, 0x0E, 0xE4,
+    0xAA, 0xC4, 0x9F, 0x80, 0x0B, 0x44, 0xBD, 0x19, 0x88, 0xAB, 0x13, 0xAB, 0x09, 0xE2, 0x1A, 0xC4,
+    0x6A, 0x82, 0xB8, 0x26, 0xB1, 0x9A, 0x20, 0xAE, 0x44, 0xBD, 0x09, 0x88, 0x2B, 0x51, 0x6F, 0x06,
+    0xE2, 0x7A, 0x8B, 0x7B, 0x80, 0xB8, 0xDD, 0xE2, 0x56, 0x20, 0x6E, 0x42, 0xAC, 0x26, 0x90, 0x1B,
+    0x51, 0x6F, 0x0F, 0xCC, 0x8D, 0xA8, 0x37, 0x05, 0x73, 0x23, 0x5E, 0xEC, 0x40, 0x6E, 0x41, 0xAC,
+    0x26, 0x90, 0x5B, 0x12, 0xAB, 0x09, 0xE4, 0x46, 0xE4, 0xDB, 0x03, 0x72, 0x23, 0xF2, 0x4D, 0x81,
+    0xDC, 0x88, 0x7C, 0x73, 0x20, 0xF7, 0x9B, 0x3C, 0x12, 0xC8, 0x5D, 0x88, 0xD5, 0x04, 0x72, 0x57,
+    0x62, 0x35, 0x81, 0xDC, 0x89, 0x7C, 0x13, 0x20, 0x77, 0x22, 0xDF, 0x0C, 0xCC, 0x9D, 0x29, 0x76,
+    0x30, 0x77, 0xE6, 0x23, 0x0D, 0x2E, 0x14, 0xF1, 0x3E, 0x04, 0x72, 0x27, 0xF2, 0x4D, 0x80, 0xDC,
+    0x89, 0x7C, 0x33, 0x20, 0x8F, 0x9B, 0xBC, 0x02, 0xC8, 0x43, 0x88, 0xD5, 0x04, 0xF2, 0x50, 0x62,
+    0x35, 0x81, 0x3C, 0x88, 0x7C, 0x7B, 0x40, 0x1E, 0xC4, 0x53, 0xAE, 0x40, 0x1E, 0x44, 0xBE, 0x39,
+    0x90, 0x47, 0x12, 0xAB, 0x09, 0xE6, 0x51, 0xC4, 0xA4, 0x81, 0x79, 0x10, 0xF9, 0xF6, 0xC0, 0x3C,
+    0x88, 0x2D, 0x07, 0xF2, 0x24, 0xF2, 0xCD, 0x81, 0x3C, 0x85, 0x98, 0x4D, 0x20, 0x4F, 0x25, 0x66,
+    0x13, 0xC8, 0xD3, 0x88, 0xD9, 0x04, 0xF2, 0x24, 0xF2, 0x4D, 0x80, 0x3C, 0x89, 0x7C, 0x33, 0x20,
+    0xCF, 0x24, 0x66, 0x13, 0xC8, 0xB3, 0x88, 0xD9, 0x04, 0xF2, 0xBC, 0xC9, 0x75, 0x80, 0x3C, 0x19,
+    0x72, 0x30, 0x2F, 0x22, 0xDF, 0x0C, 0xCC, 0x8B, 0x78, 0xB3, 0x03, 0x79, 0x29, 0x31, 0x9B, 0x40,
+    0x5E, 0x46, 0xCC, 0x26, 0x90, 0x17, 0xD1, 0x6F, 0x0F, 0xC8, 0x8B, 0xE8, 0x37, 0x05, 0xF2, 0x22,
+    0xFA, 0xCD, 0x81, 0xBC, 0x8A, 0x98, 0x4D, 0x20, 0xAF, 0x9B, 0xDC, 0x1B, 0xC8, 0x8B, 0xE8, 0xB7,
+    0x07, 0xE4, 0x4D, 0xF4, 0x9B, 0x02, 0x79, 0x13, 0xFD, 0x66, 0x60, 0xDE, 0x44, 0xB2, 0x07, 0x98,
+    0x37, 0xF1, 0x95, 0x06, 0xE4, 0xED, 0xC4, 0x6C, 0x02, 0x79, 0x13, 0xFD, 0x26, 0x40, 0xDE, 0x44,
+    0xBF, 0x19, 0x90, 0x77, 0x11, 0xB3, 0x09, 0xE4, 0x7D, 0x93, 0x67, 0x01, 0x79, 0xDF, 0xE4, 0x31,
+    0x40, 0x3E, 0x44, 0xBF, 0x09, 0x90, 0x0F, 0xF1, 0x94, 0x2B, 0x90, 0x0F, 0xD1, 0x6F, 0x0E, 0xE4,
+    0x63, 0xC4, 0x6C, 0x82, 0xF9, 0x38, 0x31, 0x9B, 0x60, 0x3E, 0x44, 0xBF, 0x3D, 0x30, 0x1F, 0x62,
+    0xCC, 0x81, 0x7C, 0x88, 0x7E, 0x73, 0x20, 0x9F, 0x9B, 0xBC, 0x13, 0xC8, 0xE7, 0x26, 0xAF, 0xDE,
+    0xE4, 0xFF, 0x07, 0x0A, 0x6E, 0x15, 0x25, 0x07, 0x3A, 0x00, 0x00,
+};
+
+// Hand-built fixed block: "a", 16 matches of 258 at distance 1, then a
+// match at distance 4096; 4132 bytes of "a"
+static const uint8_t NEAR_MATCH_GZIP[] = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x4B, 0x1C, 0x05, 0xA3, 0x60, 0x14,
+    0x8C, 0x82, 0x51, 0x30, 0x0A, 0x46, 0xC1, 0x28, 0x18, 0x05, 0xA3, 0x60, 0x14, 0x8C, 0x82, 0x51,
+    0x30, 0x0A, 0x46, 0xC1, 0x28, 0x00, 0xF6, 0xFF, 0x01, 0x3E, 0x64, 0xA0, 0x8E, 0x24, 0x10, 0x00,
+    0x00,
+};
+
+// The same with the last match at distance 4100, past the 4 KB window
+static const uint8_t FAR_MATCH_GZIP[] = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x4B, 0x1C, 0x05, 0xA3, 0x60, 0x14,
+    0x8C, 0x82, 0x51, 0x30, 0x0A, 0x46, 0xC1, 0x28, 0x18, 0x05, 0xA3, 0x60, 0x14, 0x8C, 0x82, 0x51,
+    0x30, 0x0A, 0x46, 0xC1, 0x28, 0x00, 0x8E, 0x01, 0x00, 0x00, 0x3E, 0x64, 0xA0, 0x8E, 0x24, 0x10,
+    0x00, 0x00,
+};
+
+#endif // GZIP_VECTORS_H
@@ -0,0 +1,154 @@
+#include <unity.h>
+#include <Wire.h>
+#include "Pca9685Backend.h"
+
+#define ADDRESS 0x40
+
+static uint16_t word(const uint8_t *burst, int channel, int offset)
+{
+    const uint8_t *p = &burst[1 + channel * 4 + offset];
+    return p[0] | (p[1] << 8);
+}
+
+static uint16_t onWord(const uint8_t *burst, int channel) { return word(burst, channel, 0); }
+static uint16_t offWord(const uint8_t *burst, int channel) { return word(burst, channel, 2); }
+
+void setUp()
+{
+    Wire.transmissions.clear();
+    Wire.result = 0;
+}
+
+void tearDown() {}
+
+void test_burst_starts_at_led0_on_l()
+{
+    uint16_t duty[PCA9685_CHANNELS] = {0};
+    uint8_t burst[PCA9685_BURST_SIZE];
+    Pca9685Backend::buildBurst(duty, false, burst);
+    TEST_ASSERT_EQUAL_UINT32(65, PCA9685_BURST_SIZE);
+    TEST_ASSERT_EQUAL_HEX8(0x06, burst[0]);
+}
+
+void test_aligned_burst_words()
+{
+    uint16_t duty[PCA9685_CHANNELS];
+    for (int i = 0; i < PCA9685_CHANNELS; i++)
+        duty[i] = 1 + i * 200;
+    uint8_t burst[PCA9685_BURST_SIZE];
+    Pca9685Backend::buildBurst(duty, false, burst);
+    for (int i = 0; i < PCA9685_CHANNELS; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX16(0, onWord(burst, i));
+        TEST_ASSERT_EQUAL_HEX16(duty[i], offWord(burst, i));
+    }
+}
+
+void test_staggered_burst_words()
+{
+    uint16_t duty[PCA9685_CHANNELS];
+    for (int i = 0; i < PCA9685_CHANNELS; i++)
+        duty[i] = 3000;
+    uint8_t burst[PCA9685_BURST_SIZE];
+    Pca9685Backend::buildBurst(duty, true, burst);
+    for (int i = 0; i < PCA9685_CHANNELS; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX16(i * 256, onWord(burst, i));
+        // Past the end of the period the OFF time wraps into the next one
+        TEST_ASSERT_EQUAL_HEX16((i * 256 + 3000) & 0x0FFF, offWord(burst, i));
+    }
+}
+
+void test_full_on_and_full_off_bits()
+{
+    uint16_t duty[PCA9685_CHANNELS] = {0};
+    duty[1] = LED_DUTY_MAX;
+    duty[2] = 1;
+    duty[3] = LED_DUTY_MAX - 1;
+    uint8_t burst[PCA9685_BURST_SIZE];
+    for (int staggered = 0; staggered < 2; staggered++)
+    {
+        Pca9685Backend::buildBurst(duty, staggered, burst);
+        // Duty 0: full-off is bit 4 of OFF_H, ON is ignored by the chip
+        TEST_ASSERT_EQUAL_HEX8(0x10, burst[1 + 0 * 4 + 3]);
+        TEST_ASSERT_EQUAL_HEX16(0x1000, offWord(burst, 0));
+        // Duty max: full-on is bit 4 of ON_H and OFF must not carry full-off
+        TEST_ASSERT_EQUAL_HEX16(0x1000, onWord(burst, 1));
+        TEST_ASSERT_EQUAL_HEX16(0, offWord(burst, 1));
+        // Anything in between uses neither bit
+        TEST_ASSERT_EQUAL_HEX8(0, burst[1 + 2 * 4 + 1] & 0x10);
+        TEST_ASSERT_EQUAL_HEX8(0, burst[1 + 2 * 4 + 3] & 0x10);
+        TEST_ASSERT_EQUAL_HEX8(0, burst[1 + 3 * 4 + 1] & 0x10);
+        TEST_ASSERT_EQUAL_HEX8(0, burst[1 + 3 * 4 + 3] & 0x10);
+    }
+}
+
+void test_flush_sends_one_burst_when_dirty()
+{
+    Pca9685Backend pca(ADDRESS);
+    TEST_ASSERT_TRUE(pca.begin());
+    Wire.transmissions.clear();
+
+    pca.write(0, 100);
+    pca.write(15, 4000);
+    pca.flush();
+    TEST_ASSERT_EQUAL_UINT32(1, Wire.transmissions.size());
+    const TwoWire::Transmission &sent = Wire.transmissions[0];
+    TEST_ASSERT_EQUAL_HEX8(ADDRESS, sent.address);
+    TEST_ASSERT_EQUAL_UINT32(PCA9685_BURST_SIZE, sent.bytes.size());
+
+    uint16_t duty[PCA9685_CHANNELS] = {0};
+    duty[0] = 100;
+    duty[15] = 4000;
+    uint8_t expected[PCA9685_BURST_SIZE];
+    Pca9685Backend::buildBurst(duty, false, expected);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, sent.bytes.data(), PCA9685_BURST_SIZE);
+
+    // Unchanged duties are not resent
+    pca.write(0, 100);
+    pca.flush();
+    TEST_ASSERT_EQUAL_UINT32(1, Wire.transmissions.size());
+    TEST_ASSERT_EQUAL_UINT32(2, pca.getBursts()); // begin() sent the first one
+}
+
+void test_failed_burst_is_retried()
+{
+    Pca9685Backend pca(ADDRESS);
+    TEST_ASSERT_TRUE(pca.begin());
+    Wire.transmissions.clear();
+
+    Wire.result = 2;
+    pca.write(4, 2048);
+    pca.flush();
+    TEST_ASSERT_EQUAL_UINT32(1, Wire.transmissions.size());
+
+    Wire.result = 0;
+    pca.flush();
+    TEST_ASSERT_EQUAL_UINT32(2, Wire.transmissions.size());
+    TEST_ASSERT_EQUAL_UINT32(PCA9685_BURST_SIZE, Wire.transmissions[1].bytes.size());
+    TEST_ASSERT_EQUAL_HEX16(2048, offWord(Wire.transmissions[1].bytes.data(), 4));
+}
+
+void test_missing_chip_sends_nothing()
+{
+    Wire.result = 2;
+    Pca9685Backend pca(ADDRESS);
+    TEST_ASSERT_FALSE(pca.begin());
+    Wire.transmissions.clear();
+    pca.write(0, 1000);
+    pca.flush();
+    TEST_ASSERT_EQUAL_UINT32(0, Wire.transmissions.size());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_burst_starts_at_led0_on_l);
+    RUN_TEST(test_aligned_burst_words);
+    RUN_TEST(test_staggered_burst_words);
+    RUN_TEST(test_full_on_and_full_off_bits);
+    RUN_TEST(test_flush_sends_one_burst_when_dirty);
+    RUN_TEST(test_failed_burst_is_retried);
+    RUN_TEST(test_missing_chip_sends_nothing);
+    return UNITY_END();
+}
@@ -0,0 +1,174 @@
+#include <unity.h>
+#include <stdio.h>
+#include <time.h>
+#include "Profiler.h"
+
+static void sleepMs(long ms)
+{
+    timespec delay = {0, ms * 1000000L};
+    nanosleep(&delay, nullptr);
+}
+
+static void profiledWork()
+{
+    PROFILE_ZONE("work");
+    sleepMs(2);
+}
+
+void setUp()
+{
+    Profiler::reset();
+}
+
+void tearDown() {}
+
+void test_zone_names_register_once()
+{
+    uint8_t a = Profiler::zone("a");
+    uint8_t b = Profiler::zone("b");
+    TEST_ASSERT_TRUE(a != b);
+    TEST_ASSERT_EQUAL_UINT8(a, Profiler::zone("a"));
+    TEST_ASSERT_EQUAL_STRING("b", Profiler::getZone(b).name);
+}
+
+void test_record_keeps_count_min_max_and_histogram()
+{
+    uint8_t zone = Profiler::zone("record");
+    Profiler::record(zone, 1);
+    Profiler::record(zone, 3);
+    Profiler::record(zone, 100);
+    Profiler::record(zone, 1000);
+
+    const Profiler::Zone &z = Profiler::getZone(zone);
+    TEST_ASSERT_EQUAL_UINT32(4, z.count);
+    TEST_ASSERT_EQUAL_UINT32(1, z.minTicks);
+    TEST_ASSERT_EQUAL_UINT32(1000, z.maxTicks);
+    TEST_ASSERT_EQUAL_UINT32(1104, (uint32_t)z.totalTicks);
+    TEST_ASSERT_EQUAL_UINT32(1, z.histogram[Profiler::bucket(1)]);
+    TEST_ASSERT_EQUAL_UINT32(1, z.histogram[Profiler::bucket(3)]);
+    TEST_ASSERT_EQUAL_UINT32(1, z.histogram[Profiler::bucket(100)]);
+    TEST_ASSERT_EQUAL_UINT32(1, z.histogram[Profiler::bucket(1000)]);
+}
+
+void test_buckets_split_powers_of_two()
+{
+    // Small values are exact, then four buckets per power of two
+    TEST_ASSERT_EQUAL_UINT8(3, Profiler::bucket(3));
+    TEST_ASSERT_EQUAL_UINT8(4, Profiler::bucket(4));
+    TEST_ASSERT_EQUAL_UINT8(7, Profiler::bucket(7));
+    TEST_ASSERT_EQUAL_UINT8(8, Profiler::bucket(8));
+    TEST_ASSERT_EQUAL_UINT8(9, Profiler::bucket(10));
+    // 100 is in [96, 112), 1000 in [896, 1024)
+    TEST_ASSERT_EQUAL_UINT32(111, Profiler::bucketUpper(Profiler::bucket(100)));
+    TEST_ASSERT_EQUAL_UINT32(1023, Profiler::bucketUpper(Profiler::bucket(1000)));
+    TEST_ASSERT_EQUAL_UINT8(PROFILER_BUCKETS - 1, Profiler::bucket(UINT32_MAX));
+
+    // Buckets are contiguous and no wider than PROFILER_RESOLUTION_PCT of their start
+    uint32_t lower = 0;
+    for (uint8_t i = 0; i < PROFILER_BUCKETS - 1; i++)
+    {
+        uint32_t upper = Profiler::bucketUpper(i);
+        TEST_ASSERT_EQUAL_UINT8(i, Profiler::bucket(lower));
+        TEST_ASSERT_EQUAL_UINT8(i, Profiler::bucket(upper));
+        TEST_ASSERT_TRUE((upper - lower) * 100 <= lower * PROFILER_RESOLUTION_PCT);
+        lower = upper + 1;
+    }
+}
+
+void test_percentiles()
+{
+    uint8_t zone = Profiler::zone("percentile");
+    TEST_ASSERT_EQUAL_UINT32(0, Profiler::percentile(Profiler::getZone(zone), 0.5f));
+    for (int i = 0; i < 90; i++)
+        Profiler::record(zone, 10);
+    for (int i = 0; i < 10; i++)
+        Profiler::record(zone, 5000);
+
+    const Profiler::Zone &z = Profiler::getZone(zone);
+    // 10 is in [10, 12)
+    TEST_ASSERT_EQUAL_UINT32(11, Profiler::percentile(z, 0.5f));
+    TEST_ASSERT_EQUAL_UINT32(11, Profiler::percentile(z, 0.89f));
+    // The top bucket is capped at the largest sample
+    TEST_ASSERT_EQUAL_UINT32(5000, Profiler::percentile(z, 0.95f));
+    TEST_ASSERT_EQUAL_UINT32(5000, Profiler::percentile(z, 0.99f));
+}
+
+void test_percentiles_within_resolution()
+{
+    uint8_t zone = Profiler::zone("spread");
+    for (uint32_t ticks = 1000; ticks < 3000; ticks++)
+        Profiler::record(zone, ticks);
+    const Profiler::Zone &z = Profiler::getZone(zone);
+    uint32_t p50 = Profiler::percentile(z, 0.5f);
+    uint32_t p99 = Profiler::percentile(z, 0.99f);
+    TEST_ASSERT_TRUE(p50 >= 2000 && p50 <= 2000 * (100 + PROFILER_RESOLUTION_PCT) / 100);
+    TEST_ASSERT_TRUE(p99 >= 2980 && p99 <= 2999);
+}
+
+void test_full_bucket_halves_histogram()
+{
+    uint8_t zone = Profiler::zone("halve");
+    for (uint32_t i = 0; i < 70000; i++)
+        Profiler::record(zone, 10);
+    for (uint32_t i = 0; i < 30000; i++)
+        Profiler::record(zone, 5000);
+    const Profiler::Zone &z = Profiler::getZone(zone);
+    TEST_ASSERT_EQUAL_UINT32(100000, z.count);
+    // The halving happened once, after 65535 samples of 10
+    TEST_ASSERT_EQUAL_UINT32(70000 - 65535 + 32767, z.histogram[Profiler::bucket(10)]);
+    TEST_ASSERT_EQUAL_UINT32(30000, z.histogram[Profiler::bucket(5000)]);
+    TEST_ASSERT_EQUAL_UINT32(11, Profiler::percentile(z, 0.5f));
+    TEST_ASSERT_EQUAL_UINT32(5000, Profiler::percentile(z, 0.9f));
+}
+
+void test_reset_keeps_zones()
+{
+    uint8_t zone = Profiler::zone("reset");
+    Profiler::record(zone, 42);
+    Profiler::reset();
+    const Profiler::Zone &z = Profiler::getZone(zone);
+    TEST_ASSERT_EQUAL_STRING("reset", z.name);
+    TEST_ASSERT_EQUAL_UINT32(0, z.count);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, z.minTicks);
+    TEST_ASSERT_EQUAL_UINT8(zone, Profiler::zone("reset"));
+}
+
+void test_profile_zone_times_its_scope()
+{
+    profiledWork();
+    profiledWork();
+    const Profiler::Zone &z = Profiler::getZone(Profiler::zone("work"));
+    TEST_ASSERT_EQUAL_UINT32(2, z.count);
+    // Host ticks are nanoseconds
+    TEST_ASSERT_EQUAL_UINT32(1000, Profiler::ticksPerMicrosecond());
+    TEST_ASSERT_TRUE(z.minTicks >= 2000 * Profiler::ticksPerMicrosecond());
+    TEST_ASSERT_TRUE(z.maxTicks < 1000000 * Profiler::ticksPerMicrosecond());
+}
+
+void test_zone_table_fills_up()
+{
+    static char names[PROFILER_MAX_ZONES][8];
+    for (int i = 0; i < PROFILER_MAX_ZONES; i++)
+    {
+        snprintf(names[i], sizeof(names[i]), "z%d", i);
+        Profiler::zone(names[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(PROFILER_MAX_ZONES, Profiler::getZoneCount());
+    TEST_ASSERT_EQUAL_UINT8(0xFF, Profiler::zone("overflow"));
+    Profiler::record(0xFF, 1); // Ignored
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_zone_names_register_once);
+    RUN_TEST(test_record_keeps_count_min_max_and_histogram);
+    RUN_TEST(test_buckets_split_powers_of_two);
+    RUN_TEST(test_percentiles);
+    RUN_TEST(test_percentiles_within_resolution);
+    RUN_TEST(test_full_bucket_halves_histogram);
+    RUN_TEST(test_reset_keeps_zones);
+    RUN_TEST(test_profile_zone_times_its_scope);
+    RUN_TEST(test_zone_table_fills_up); // Last, it uses up the zone table
+    return UNITY_END();
+}
@@ -0,0 +1,227 @@
+#include <unity.h>
+#include "SoftPwmBackend.h"
+
+#define PERIOD (SOFT_PWM_TICKS_PER_US * 1000000UL / LED_PWM_FREQ)
+#define MIN_GAP (SOFT_PWM_TICKS_PER_US * SOFT_PWM_MIN_GAP_US)
+#define NONE 0xFFFFFFFFUL
+
+typedef SoftPwmBackend::Table Table;
+
+static uint16_t duty[SOFT_PWM_MAX_PINS];
+static uint32_t configured;
+static Table table;
+
+// When in the period each pin rises and falls, NONE if it never does
+static uint32_t riseAt[SOFT_PWM_MAX_PINS];
+static uint32_t fallAt[SOFT_PWM_MAX_PINS];
+
+static void use(uint8_t pin, uint16_t value)
+{
+    duty[pin] = value;
+    configured |= 1UL << pin;
+}
+
+static uint32_t onTicks(uint16_t value)
+{
+    uint32_t on = (uint32_t)value * PERIOD / LED_DUTY_MAX;
+    return constrain(on, MIN_GAP, PERIOD - MIN_GAP);
+}
+
+// Builds the table and checks what holds for every table: it spans exactly one
+// period, events are at least MIN_GAP apart and only touch configured pins, the
+// period start sets every configured pin's level, and after that each pin rises
+// and falls at most once
+static void build(bool staggered)
+{
+    SoftPwmBackend::buildTable(duty, configured, PERIOD, staggered, table);
+    TEST_ASSERT_TRUE(table.count >= 1 && table.count <= SOFT_PWM_MAX_EVENTS);
+    for (int pin = 0; pin < SOFT_PWM_MAX_PINS; pin++)
+        riseAt[pin] = fallAt[pin] = NONE;
+
+    const SoftPwmBackend::Event &start = table.events[0];
+    TEST_ASSERT_EQUAL_HEX32(configured, start.setMask | start.clearMask);
+    uint32_t level = start.setMask;
+    uint32_t at = 0;
+    for (uint8_t i = 0; i < table.count; i++)
+    {
+        const SoftPwmBackend::Event &event = table.events[i];
+        TEST_ASSERT_EQUAL_HEX32(0, (event.setMask | event.clearMask) & ~configured);
+        TEST_ASSERT_EQUAL_HEX32(0, event.setMask & event.clearMask);
+        TEST_ASSERT_TRUE(event.ticks >= MIN_GAP || i == table.count - 1);
+        for (int pin = 0; pin < SOFT_PWM_MAX_PINS; pin++)
+        {
+            uint32_t bit = 1UL << pin;
+            // After the start events only switch pins; a pin that is set at the start
+            // and falls before it rises again has a pulse wrapped past the period end
+            if (i > 0 && (event.setMask & bit))
+            {
+                TEST_ASSERT_EQUAL_HEX32(0, level & bit);
+                TEST_ASSERT_EQUAL_UINT32(NONE, riseAt[pin]);
+                riseAt[pin] = at;
+                level |= bit;
+            }
+            if (i > 0 && (event.clearMask & bit))
+            {
+                TEST_ASSERT_TRUE(level & bit);
+                TEST_ASSERT_EQUAL_UINT32(NONE, fallAt[pin]);
+                fallAt[pin] = at;
+                level &= ~bit;
+            }
+        }
+        at += event.ticks;
+    }
+    TEST_ASSERT_EQUAL_UINT32(PERIOD, at);
+    // A pin that never switched after the start rose or fell there
+    for (int pin = 0; pin < SOFT_PWM_MAX_PINS; pin++)
+    {
+        uint32_t bit = 1UL << pin;
+        if (riseAt[pin] == NONE && fallAt[pin] != NONE)
+            riseAt[pin] = 0;
+        else if (fallAt[pin] == NONE && riseAt[pin] != NONE)
+            fallAt[pin] = 0;
+        else if (riseAt[pin] == NONE && fallAt[pin] == NONE && (configured & bit))
+            (start.setMask & bit ? riseAt[pin] : fallAt[pin]) = 0;
+    }
+}
+
+// High time of a pulsing pin, across the period end if its fall wraps
+static uint32_t highTicks(uint8_t pin)
+{
+    return (fallAt[pin] + PERIOD - riseAt[pin]) % PERIOD;
+}
+
+void setUp()
+{
+    memset(duty, 0, sizeof(duty));
+    configured = 0;
+}
+
+void tearDown() {}
+
+void test_aligned_duty()
+{
+    use(4, 1024);
+    use(5, 2048);
+    use(12, 3000);
+    use(16, 100);
+    build(false);
+
+    const uint8_t pins[] = {4, 5, 12, 16};
+    for (uint8_t pin : pins)
+    {
+        TEST_ASSERT_EQUAL_UINT32(0, riseAt[pin]);
+        TEST_ASSERT_EQUAL_UINT32(onTicks(duty[pin]), fallAt[pin]);
+    }
+    // One shared rise plus a fall per pin
+    TEST_ASSERT_EQUAL_UINT8(5, table.count);
+}
+
+void test_aligned_full_on_and_off_stay_in_the_period_start()
+{
+    use(4, 0);
+    use(5, LED_DUTY_MAX);
+    build(false);
+    TEST_ASSERT_EQUAL_UINT8(1, table.count);
+    TEST_ASSERT_EQUAL_HEX32(1UL << 5, table.events[0].setMask);
+    TEST_ASSERT_EQUAL_HEX32(1UL << 4, table.events[0].clearMask);
+}
+
+void test_aligned_short_pulses_are_stretched()
+{
+    use(4, 1);
+    use(5, LED_DUTY_MAX - 1);
+    build(false);
+    TEST_ASSERT_EQUAL_UINT32(MIN_GAP, fallAt[4]);
+    TEST_ASSERT_EQUAL_UINT32(PERIOD - MIN_GAP, fallAt[5]);
+}
+
+void test_aligned_close_falls_merge()
+{
+    use(4, 2048);
+    use(5, 2048);
+    use(12, 2050); // A few ticks later
+    build(false);
+    TEST_ASSERT_EQUAL_UINT8(2, table.count);
+    TEST_ASSERT_EQUAL_HEX32((1UL << 4) | (1UL << 5) | (1UL << 12), table.events[1].clearMask);
+    TEST_ASSERT_EQUAL_UINT32(onTicks(2048), fallAt[12]);
+}
+
+void test_staggered_phase_and_duty()
+{
+    const uint8_t pins[] = {0, 4, 5, 12, 14};
+    const uint16_t values[] = {500, 1000, 2000, 3000, 4000};
+    for (int i = 0; i < 5; i++)
+        use(pins[i], values[i]);
+    build(true);
+
+    for (int i = 0; i < 5; i++)
+    {
+        // Phases follow pin order and split the period evenly
+        TEST_ASSERT_EQUAL_UINT32(i * PERIOD / 5, riseAt[pins[i]]);
+        TEST_ASSERT_UINT32_WITHIN(MIN_GAP, onTicks(values[i]), highTicks(pins[i]));
+    }
+    // Long pulses late in the period fall early in the next one
+    TEST_ASSERT_TRUE(fallAt[14] < riseAt[14]);
+}
+
+void test_staggered_phase_ignores_duty()
+{
+    use(4, 1000);
+    use(5, 0);
+    use(12, LED_DUTY_MAX);
+    use(13, 1000);
+    build(true);
+    // Pins 5 and 12 still hold their slots, so pin 13 keeps rising 3/4 into the period
+    TEST_ASSERT_EQUAL_UINT32(0, riseAt[4]);
+    TEST_ASSERT_EQUAL_UINT32(3 * PERIOD / 4, riseAt[13]);
+    TEST_ASSERT_EQUAL_UINT32(0, riseAt[12]);
+    TEST_ASSERT_EQUAL_UINT32(0, fallAt[5]);
+}
+
+void test_staggered_fall_merges_with_next_rise()
+{
+    // Pin 5 rises half way; pin 4 falls a few ticks later and pin 5 a few
+    // ticks after the period start, so each edge rides on another event
+    use(4, 2049);
+    use(5, 2049);
+    build(true);
+    TEST_ASSERT_EQUAL_UINT8(2, table.count);
+    TEST_ASSERT_EQUAL_HEX32(1UL << 4, table.events[0].setMask);
+    TEST_ASSERT_EQUAL_HEX32(1UL << 5, table.events[0].clearMask);
+    TEST_ASSERT_EQUAL_HEX32(1UL << 5, table.events[1].setMask);
+    TEST_ASSERT_EQUAL_HEX32(1UL << 4, table.events[1].clearMask);
+    TEST_ASSERT_EQUAL_UINT32(PERIOD / 2, riseAt[5]);
+}
+
+void test_staggered_edge_near_period_end_moves_to_start()
+{
+    use(4, 1000);
+    use(5, 2044); // Falls less than MIN_GAP before the period ends
+    build(true);
+    TEST_ASSERT_TRUE((PERIOD / 2 + onTicks(2044)) % PERIOD > PERIOD - MIN_GAP);
+    TEST_ASSERT_EQUAL_UINT32(0, fallAt[5]);
+}
+
+void test_every_pin_pulsing_fits()
+{
+    for (int pin = 0; pin < SOFT_PWM_MAX_PINS; pin++)
+        use(pin, 100 + pin * 230);
+    build(true);
+    build(false);
+    TEST_ASSERT_EQUAL_UINT8(SOFT_PWM_MAX_PINS + 1, table.count);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_aligned_duty);
+    RUN_TEST(test_aligned_full_on_and_off_stay_in_the_period_start);
+    RUN_TEST(test_aligned_short_pulses_are_stretched);
+    RUN_TEST(test_aligned_close_falls_merge);
+    RUN_TEST(test_staggered_phase_and_duty);
+    RUN_TEST(test_staggered_phase_ignores_duty);
+    RUN_TEST(test_staggered_fall_merges_with_next_rise);
+    RUN_TEST(test_staggered_edge_near_period_end_moves_to_start);
+    RUN_TEST(test_every_pin_pulsing_fits);
+    return UNITY_END();
+}
@@ -0,0 +1,240 @@
+#include <unity.h>
+#include "SoftPwmBackend.h"
+
+#define PERIOD (SOFT_PWM_TICKS_PER_US * 1000000UL / LED_PWM_FREQ)
+#define MIN_GAP (SOFT_PWM_TICKS_PER_US * SOFT_PWM_MIN_GAP_US)
+
+// Simulated time in timer1 ticks since begin(), and when the interrupt fires next
+static uint64_t now;
+static uint64_t nextInterrupt;
+
+static void start(SoftPwmBackend &pwm)
+{
+    pwm.begin();
+    now = 0;
+    nextInterrupt = stubTimer1Ticks;
+}
+
+// Fires the interrupt on time until `until`, adding each pin's high time to `high`
+static void run(uint64_t until, uint32_t *high)
+{
+    while (now < until)
+    {
+        if (now == nextInterrupt)
+        {
+            stubTimer1Isr();
+            TEST_ASSERT_TRUE(stubTimer1Ticks > 0);
+            nextInterrupt = now + stubTimer1Ticks;
+        }
+        uint64_t next = nextInterrupt < until ? nextInterrupt : until;
+        for (int pin = 0; pin < SOFT_PWM_MAX_PINS; pin++)
+        {
+            if (stubGpioOut & (1UL << pin))
+                high[pin] += next - now;
+        }
+        now = next;
+    }
+}
+
+// High time of one period; edges may move by up to MIN_GAP when they merge
+static uint32_t expectedHigh(uint16_t duty)
+{
+    if (duty == 0)
+        return 0;
+    if (duty >= LED_DUTY_MAX)
+        return PERIOD;
+    uint32_t on = (uint32_t)duty * PERIOD / LED_DUTY_MAX;
+    return constrain(on, MIN_GAP, PERIOD - MIN_GAP);
+}
+
+static const uint8_t pins[] = {4, 5, 12, 13, 14, 16};
+static const uint16_t duties[] = {1, 300, 1024, 2048, 4000, 3000};
+
+void setUp()
+{
+    stubGpioOut = 0;
+}
+
+void tearDown() {}
+
+static void checkDuties(bool staggered)
+{
+    SoftPwmBackend pwm;
+    pwm.setTiming(LED_PWM_FREQ, staggered);
+    for (size_t i = 0; i < sizeof(pins); i++)
+        pwm.write(pins[i], duties[i]);
+    pwm.flush();
+    start(pwm);
+
+    uint32_t high[SOFT_PWM_MAX_PINS] = {0};
+    run(PERIOD * 2, high);
+    for (int period = 2; period < 5; period++)
+    {
+        memset(high, 0, sizeof(high));
+        run(PERIOD * (period + 1), high);
+        for (size_t i = 0; i < sizeof(pins); i++)
+            TEST_ASSERT_UINT32_WITHIN(MIN_GAP, expectedHigh(duties[i]), high[pins[i]]);
+    }
+    pwm.end(0);
+}
+
+void test_aligned_duty_per_period()
+{
+    checkDuties(false);
+}
+
+void test_staggered_duty_per_period()
+{
+    checkDuties(true);
+}
+
+void test_aligned_pins_rise_together()
+{
+    SoftPwmBackend pwm;
+    for (size_t i = 0; i < sizeof(pins); i++)
+        pwm.write(pins[i], duties[i]);
+    pwm.flush();
+    start(pwm);
+
+    uint32_t high[SOFT_PWM_MAX_PINS] = {0};
+    run(PERIOD * 2, high);
+    // Right after the period start interrupt every pulsing pin is high
+    run(PERIOD * 2 + 1, high);
+    for (size_t i = 0; i < sizeof(pins); i++)
+        TEST_ASSERT_TRUE(stubGpioOut & (1UL << pins[i]));
+    pwm.end(0);
+}
+
+void test_full_on_and_off()
+{
+    SoftPwmBackend pwm;
+    pwm.write(4, LED_DUTY_MAX);
+    pwm.write(5, 0);
+    pwm.write(16, LED_DUTY_MAX);
+    pwm.flush();
+    start(pwm);
+
+    uint32_t high[SOFT_PWM_MAX_PINS] = {0};
+    run(PERIOD * 2, high);
+    memset(high, 0, sizeof(high));
+    run(PERIOD * 3, high);
+    TEST_ASSERT_EQUAL_UINT32(PERIOD, high[4]);
+    TEST_ASSERT_EQUAL_UINT32(0, high[5]);
+    TEST_ASSERT_EQUAL_UINT32(PERIOD, high[16]);
+    // Only the period start is left to run
+    TEST_ASSERT_EQUAL_UINT8(1, pwm.getEventCount());
+    pwm.end(0);
+}
+
+void test_new_duty_waits_for_period_start()
+{
+    SoftPwmBackend pwm;
+    pwm.write(4, 2048);
+    pwm.flush();
+    start(pwm);
+
+    uint32_t high[SOFT_PWM_MAX_PINS] = {0};
+    run(PERIOD * 3, high);
+    memset(high, 0, sizeof(high));
+    run(PERIOD * 3 + PERIOD / 4, high);
+    pwm.write(4, 1024);
+    pwm.flush();
+    run(PERIOD * 4, high);
+    // The period in progress finishes with the old table
+    TEST_ASSERT_EQUAL_UINT32(expectedHigh(2048), high[4]);
+
+    memset(high, 0, sizeof(high));
+    run(PERIOD * 5, high);
+    TEST_ASSERT_EQUAL_UINT32(expectedHigh(1024), high[4]);
+    pwm.end(0);
+}
+
+// Every staggered pin steps from one duty to another at a period start; the
+// swap period must already run the new duty, whether or not the old or the
+// new pulses wrap past the period end
+static void checkSwap(uint16_t from, uint16_t to)
+{
+    SoftPwmBackend pwm;
+    pwm.setTiming(LED_PWM_FREQ, true);
+    for (size_t i = 0; i < sizeof(pins); i++)
+        pwm.write(pins[i], from);
+    pwm.flush();
+    start(pwm);
+
+    uint32_t high[SOFT_PWM_MAX_PINS] = {0};
+    run(PERIOD * 3 - PERIOD / 4, high);
+    for (size_t i = 0; i < sizeof(pins); i++)
+        pwm.write(pins[i], to);
+    pwm.flush();
+    run(PERIOD * 3, high);
+    for (int period = 3; period < 5; period++)
+    {
+        memset(high, 0, sizeof(high));
+        run(PERIOD * (period + 1), high);
+        for (size_t i = 0; i < sizeof(pins); i++)
+            TEST_ASSERT_UINT32_WITHIN(MIN_GAP, expectedHigh(to), high[pins[i]]);
+    }
+    pwm.end(0);
+}
+
+void test_staggered_fade_down_across_swap()
+{
+    checkSwap(2048, 400);
+}
+
+void test_staggered_fade_up_across_swap()
+{
+    checkSwap(400, 2048);
+}
+
+void test_staggered_switch_off_across_swap()
+{
+    checkSwap(3000, 0);
+}
+
+void test_end_releases_pins()
+{
+    SoftPwmBackend pwm;
+    pwm.write(4, LED_DUTY_MAX);
+    pwm.write(16, LED_DUTY_MAX);
+    pwm.flush();
+    start(pwm);
+    uint32_t high[SOFT_PWM_MAX_PINS] = {0};
+    run(PERIOD * 2, high);
+    TEST_ASSERT_TRUE(stubGpioOut & (1UL << 4));
+
+    pwm.end(0);
+    TEST_ASSERT_EQUAL_HEX32(0, stubGpioOut);
+    TEST_ASSERT_NULL(stubTimer1Isr);
+}
+
+void test_end_parks_active_low_pins_high()
+{
+    SoftPwmBackend pwm;
+    pwm.write(4, 0); // Full brightness on an active-low LED
+    pwm.write(5, 2048);
+    pwm.write(16, 0);
+    pwm.flush();
+    start(pwm);
+    uint32_t high[SOFT_PWM_MAX_PINS] = {0};
+    run(PERIOD * 2, high);
+
+    pwm.end(LED_DUTY_MAX);
+    TEST_ASSERT_EQUAL_HEX32((1UL << 4) | (1UL << 5) | (1UL << 16), stubGpioOut);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_aligned_duty_per_period);
+    RUN_TEST(test_staggered_duty_per_period);
+    RUN_TEST(test_aligned_pins_rise_together);
+    RUN_TEST(test_full_on_and_off);
+    RUN_TEST(test_new_duty_waits_for_period_start);
+    RUN_TEST(test_staggered_fade_down_across_swap);
+    RUN_TEST(test_staggered_fade_up_across_swap);
+    RUN_TEST(test_staggered_switch_off_across_swap);
+    RUN_TEST(test_end_releases_pins);
+    RUN_TEST(test_end_parks_active_low_pins_high);
+    return UNITY_END();
+}
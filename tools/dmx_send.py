@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Stream DMX frames to a ledbar over E1.31 (sACN) or Art-Net.
+
+  dmx_send.py --universe 1 --chase                 moving chase on the universe's multicast group
+  dmx_send.py --artnet --host 192.168.1.50 --level 128
+  dmx_send.py --universe 1 --levels 255,0,64 --start 10 --seconds 5
+  dmx_send.py --host 127.0.0.1 --port 5569 --chase & dmx_send.py --listen --port 5569
+                                                   loopback: decode with the device's rules
+
+The stream runs at --fps (default 44, the DMX refresh rate) for --seconds
+and then sends E1.31 stream-terminated packets, so the device fades back to
+its stored state at once instead of waiting for its timeout.
+"""
+import argparse
+import math
+import socket
+import struct
+import sys
+import time
+import uuid
+
+E131_PORT = 5568
+ARTNET_PORT = 6454
+ACN_ID = b"ASC-E1.17\x00\x00\x00"
+E131_HEADER = 126
+ARTNET_HEADER = 18
+OPTION_TERMINATED = 0x40
+
+
+def e131_packet(universe, sequence, slots, cid, terminated=False):
+    count = len(slots)
+    root = struct.pack(">HH12sHI16s", 0x0010, 0, ACN_ID, 0x7000 | (110 + count), 0x00000004, cid)
+    framing = struct.pack(">HI64sBHBBH", 0x7000 | (88 + count), 0x00000002, b"ledbar dmx_send".ljust(64, b"\0"),
+                          100, 0, sequence, OPTION_TERMINATED if terminated else 0, universe)
+    dmp = struct.pack(">HBBHHHB", 0x7000 | (11 + count), 0x02, 0xA1, 0, 1, count + 1, 0)
+    return root + framing + dmp + bytes(slots)
+
+
+def artnet_packet(universe, sequence, slots):
+    data = bytes(slots) + (b"\0" if len(slots) % 2 else b"")  # ArtDmx length must be even
+    header = b"Art-Net\0" + struct.pack("<H", 0x5000)  # OpDmx is little-endian, the rest big-endian
+    return header + struct.pack(">HBBBBH", 14, sequence, 0, universe & 0xFF, (universe >> 8) & 0x7F, len(data)) + data
+
+
+def frame(args, t):
+    slots = [0] * (args.start - 1 + args.channels)
+    if args.levels:
+        values = [int(v) for v in args.levels.split(",")]
+    elif args.chase:
+        values = [int(127.5 + 127.5 * math.sin(2 * math.pi * (t * args.speed - i / args.channels)))
+                  for i in range(args.channels)]
+    else:
+        values = [args.level] * args.channels
+    for i, value in enumerate(values[:args.channels]):
+        slots[args.start - 1 + i] = max(0, min(255, value))
+    return slots
+
+
+def send(args):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 1)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+    if args.artnet:
+        target = (args.host or "255.255.255.255", args.port or ARTNET_PORT)
+    else:
+        target = (args.host or f"239.255.{args.universe >> 8}.{args.universe & 0xFF}", args.port or E131_PORT)
+    cid = uuid.uuid4().bytes
+    interval = 1.0 / args.fps
+    start = time.monotonic()
+    sequence = 0
+    frames = 0
+    while time.monotonic() - start < args.seconds:
+        sequence = (sequence + 1) & 0xFF
+        slots = frame(args, time.monotonic() - start)
+        if args.artnet:
+            packet = artnet_packet(args.universe, sequence or 1, slots)
+        else:
+            packet = e131_packet(args.universe, sequence, slots, cid)
+        sock.sendto(packet, target)
+        frames += 1
+        time.sleep(max(0.0, start + frames * interval - time.monotonic()))
+    if not args.artnet:
+        for _ in range(3):
+            sequence = (sequence + 1) & 0xFF
+            sock.sendto(e131_packet(args.universe, sequence, slots, cid, terminated=True), target)
+    print(f"sent {frames} frames to {target[0]}:{target[1]} ({frames / args.seconds:.1f} fps)")
+
+
+def listen(args):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", args.port or (ARTNET_PORT if args.artnet else E131_PORT)))
+    if not args.artnet and not args.host:
+        group = f"239.255.{args.universe >> 8}.{args.universe & 0xFF}"
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, socket.inet_aton(group) + socket.inet_aton("0.0.0.0"))
+    sock.settimeout(2.5)  # DMX_TIMEOUT_MS
+    frames, window = 0, time.monotonic()
+    while True:
+        try:
+            data = sock.recv(1024)
+        except socket.timeout:
+            print("timeout: device would restore its stored state")
+            continue
+        # Same checks as DmxReceiver::readE131() / readArtNet()
+        if data[:8] == b"Art-Net\0" and len(data) >= ARTNET_HEADER and data[8:10] == b"\x00\x50":
+            universe = ((data[15] & 0x7F) << 8) | data[14]
+            slots = data[ARTNET_HEADER:ARTNET_HEADER + struct.unpack(">H", data[16:18])[0]]
+            sequence, terminated = data[12], False
+        elif len(data) >= E131_HEADER and data[4:16] == ACN_ID and data[21] == 4 and data[43] == 2 and data[125] == 0:
+            universe = struct.unpack(">H", data[113:115])[0]
+            slots = data[E131_HEADER:E131_HEADER + struct.unpack(">H", data[123:125])[0] - 1]
+            sequence, terminated = data[111], bool(data[112] & OPTION_TERMINATED)
+        else:
+            print(f"ignored {len(data)} byte packet")
+            continue
+        if universe != args.universe:
+            continue
+        if terminated:
+            print("stream terminated: device restores its stored state")
+            continue
+        frames += 1
+        now = time.monotonic()
+        mapped = list(slots[args.start - 1:args.start - 1 + args.channels])
+        if now - window >= 1.0:
+            print(f"universe {universe} seq {sequence:3d} {frames / (now - window):5.1f} fps slots {mapped}")
+            frames, window = 0, now
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--artnet", action="store_true", help="send Art-Net instead of E1.31")
+    parser.add_argument("--universe", type=int, default=1)
+    parser.add_argument("--start", type=int, default=1, help="slot of the first channel (dmxStartSlot)")
+    parser.add_argument("--channels", type=int, default=4)
+    pattern = parser.add_mutually_exclusive_group()
+    pattern.add_argument("--chase", action="store_true", help="sine wave running across the channels")
+    pattern.add_argument("--level", type=int, default=255, help="same level on every channel")
+    pattern.add_argument("--levels", help="comma separated levels, one per channel")
+    parser.add_argument("--speed", type=float, default=0.5, help="chase cycles per second")
+    parser.add_argument("--fps", type=float, default=44)
+    parser.add_argument("--seconds", type=float, default=10)
+    parser.add_argument("--host", help="unicast target, default the universe's multicast group (E1.31) or broadcast")
+    parser.add_argument("--port", type=int)
+    parser.add_argument("--listen", action="store_true", help="decode frames instead of sending")
+    args = parser.parse_args()
+    if not 1 <= args.start <= 512 or args.start - 1 + args.channels > 512:
+        parser.error("channels must fit in slots 1-512")
+
+    if args.listen:
+        listen(args)
+    else:
+        send(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Send group control datagrams to every ledbar in a multicast group.
+
+  group_send.py --group 2 --on --brightness 60      channel(s) on at 60%
+  group_send.py --group 0 --off                     every device off
+  group_send.py --group 2 --toggle --channel 1
+  group_send.py --group 2 --adjust -10              dim channels that are on
+  group_send.py --group 2 --scene 0 --transition 1500   recall each device's first scene
+  group_send.py --listen [--group 2]                decode packets (e.g. on loopback)
+
+Each command gets a new sequence number and is repeated --repeat times;
+devices drop duplicates and anything older than the last sequence seen from
+this sender. The packet layout matches GroupPacket in src/GroupControl.h.
+"""
+import argparse
+import os
+import socket
+import struct
+import sys
+import time
+
+GROUP_ADDR = "239.255.76.66"
+GROUP_PORT = 4210
+PACKET = struct.Struct("<4sHBBIIhBBH")
+MAGIC = b"LBG1"
+ALL_CHANNELS = 0xFF
+COMMANDS = {1: "set", 2: "toggle", 3: "adjust", 4: "scene"}
+
+
+def build(args, sequence, sender):
+    if args.toggle:
+        command, value, state = 2, -1, 0
+    elif args.adjust is not None:
+        command, value, state = 3, args.adjust, 0
+    elif args.scene is not None:
+        command, value, state = 4, args.scene, 0
+    else:
+        command, value, state = 1, args.brightness, 0 if args.off else 1
+    channel = ALL_CHANNELS if args.channel is None else args.channel
+    return PACKET.pack(MAGIC, args.group, command, channel, sender, sequence, value, state, 0, args.transition)
+
+
+def send(args):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, args.ttl)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+    if args.interface:
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF, socket.inet_aton(args.interface))
+    # Milliseconds since the epoch keep sequences increasing across runs of this tool
+    sequence = int(time.time() * 1000) & 0xFFFFFFFF
+    sender = args.sender if args.sender is not None else struct.unpack("<I", os.urandom(4))[0]
+    packet = build(args, sequence, sender)
+    for i in range(args.repeat):
+        sock.sendto(packet, (args.addr, args.port))
+        if i + 1 < args.repeat:
+            time.sleep(0.005)
+    print(f"sent group {args.group} seq {sequence} sender {sender:08x} x{args.repeat}")
+
+
+def listen(args):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", args.port))
+    interface = socket.inet_aton(args.interface or "0.0.0.0")
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, socket.inet_aton(args.addr) + interface)
+    last = {}
+    while True:
+        data, source = sock.recvfrom(64)
+        if len(data) != PACKET.size or data[:4] != MAGIC:
+            print(f"{source[0]}: malformed ({len(data)} bytes)")
+            continue
+        _, group, command, channel, sender, sequence, value, state, _, transition = PACKET.unpack(data)
+        # Same rule as GroupControl::isFresh()
+        previous = last.get(sender)
+        fresh = previous is None or 0 < ((sequence - previous) & 0xFFFFFFFF) < 0x80000000
+        if fresh:
+            last[sender] = sequence
+        if args.group not in (None, 0) and group not in (0, args.group):
+            continue
+        target = "all" if channel == ALL_CHANNELS else channel
+        print(f"{source[0]}: group {group} {COMMANDS.get(command, command)} channel {target} value {value} "
+              f"state {state} transition {transition} ms seq {sequence} {'' if fresh else '(dropped)'}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--group", type=int, default=None, help="group id, 0 addresses every device")
+    parser.add_argument("--channel", type=int, help="channel index, default all channels")
+    action = parser.add_mutually_exclusive_group()
+    action.add_argument("--on", action="store_true")
+    action.add_argument("--off", action="store_true")
+    action.add_argument("--toggle", action="store_true")
+    action.add_argument("--adjust", type=int, metavar="DELTA")
+    action.add_argument("--scene", type=int, metavar="INDEX", help="scene number, in each device's own scene list")
+    action.add_argument("--listen", action="store_true")
+    parser.add_argument("--brightness", type=int, default=-1, help="0-100, default keeps the current value")
+    parser.add_argument("--transition", type=int, default=0, metavar="MS")
+    parser.add_argument("--repeat", type=int, default=3, help="copies per command, duplicates are dropped")
+    parser.add_argument("--sender", type=lambda s: int(s, 0), help="fixed sender id, default random")
+    parser.add_argument("--addr", default=GROUP_ADDR)
+    parser.add_argument("--port", type=int, default=GROUP_PORT)
+    parser.add_argument("--interface", help="local address to send/listen on, e.g. 127.0.0.1")
+    parser.add_argument("--ttl", type=int, default=1)
+    args = parser.parse_args()
+
+    if args.listen:
+        listen(args)
+        return 0
+    if args.group is None:
+        parser.error("--group is required when sending")
+    send(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
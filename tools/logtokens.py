@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""Token dictionary generator and decoder for LOGT_* tokenized logging.
+
+  logtokens.py generate            scan src/ and write data/logtokens.json
+  logtokens.py decode [FILE|-]     decode a captured serial stream (text and
+                                   binary records interleaved) to plain text
+
+Build with -DLOG_TOKENIZED to make LOGT_* emit binary records (see src/LogToken.h).
+"""
+import json
+import re
+import struct
+import sys
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent.parent
+SRC_DIR = ROOT / "src"
+TOKENS_FILE = ROOT / "data" / "logtokens.json"
+
+RECORD_MARKER = 0x1E
+LEVELS = "FEWITV"
+CALL_RE = re.compile(r'LOGT_[A-Z]+\(\s*"((?:[^"\\]|\\.)*)"')
+ESCAPES = {"n": "\n", "t": "\t", "r": "\r", '"': '"', "\\": "\\"}
+
+
+def unescape(literal):
+    return re.sub(r"\\(.)", lambda m: ESCAPES.get(m.group(1), m.group(1)), literal)
+
+
+def token_hash(fmt):
+    """FNV-1a, must match LogToken::hash()."""
+    h = 2166136261
+    for b in fmt.encode("utf-8"):
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def generate():
+    tokens = {}
+    for path in sorted(SRC_DIR.glob("*.[ch]*")):
+        for match in CALL_RE.finditer(path.read_text()):
+            fmt = unescape(match.group(1))
+            key = "%08x" % token_hash(fmt)
+            if key in tokens and tokens[key] != fmt:
+                sys.exit("token collision between %r and %r" % (tokens[key], fmt))
+            tokens[key] = fmt
+    TOKENS_FILE.write_text(json.dumps(tokens, indent=2, sort_keys=True) + "\n")
+    print("wrote %d tokens to %s" % (len(tokens), TOKENS_FILE.relative_to(ROOT)))
+
+
+def format_record(tokens, level, token, args):
+    """Mirror ArduinoLog's single character conversions."""
+    fmt = tokens.get("%08x" % token)
+    if fmt is None:
+        return "%s: <unknown token %08x>" % (LEVELS[level - 1], token)
+    out = []
+    pos = 0
+    i = 0
+    while i < len(fmt):
+        c = fmt[i]
+        i += 1
+        if c != "%":
+            out.append(c)
+            continue
+        if i >= len(fmt):
+            break
+        spec = fmt[i]
+        i += 1
+        if spec == "%":
+            out.append("%")
+        elif spec == "s":
+            n = args[pos]
+            out.append(args[pos + 1:pos + 1 + n].decode("utf-8", "replace"))
+            pos += 1 + n
+        elif spec in "DF":
+            out.append("%.2f" % struct.unpack_from("<f", args, pos)[0])
+            pos += 4
+        elif spec in "dilxXbBucCtT":
+            value = struct.unpack_from("<i", args, pos)[0]
+            pos += 4
+            if spec in "xX":
+                out.append(("0x%04X" if spec == "X" else "%x") % (value & 0xFFFFFFFF))
+            elif spec in "bB":
+                out.append(("0b" if spec == "B" else "") + bin(value & 0xFFFFFFFF)[2:])
+            elif spec == "u":
+                out.append(str(value & 0xFFFFFFFF))
+            elif spec in "cC":
+                out.append(chr(value & 0xFF))
+            elif spec == "t":
+                out.append("T" if value == 1 else "F")
+            elif spec == "T":
+                out.append("true" if value == 1 else "false")
+            else:
+                out.append(str(value))
+    return "%s: %s" % (LEVELS[level - 1], "".join(out))
+
+
+def decode(stream):
+    tokens = json.loads(TOKENS_FILE.read_text())
+    data = stream.read()
+    i = 0
+    text = bytearray()
+    while i < len(data):
+        if data[i] == RECORD_MARKER and i + 7 <= len(data):
+            length = data[i + 1]
+            record = data[i + 2:i + 2 + length]
+            i += 2 + length
+            if len(record) < 5:
+                continue
+            level = record[0]
+            token = struct.unpack_from("<I", record, 1)[0]
+            sys.stdout.write(text.decode("utf-8", "replace"))
+            text.clear()
+            sys.stdout.write(format_record(tokens, level, token, record[5:]) + "\n")
+        else:
+            text.append(data[i])
+            i += 1
+    sys.stdout.write(text.decode("utf-8", "replace"))
+
+
+def main(argv):
+    if len(argv) < 2 or argv[1] not in ("generate", "decode"):
+        sys.exit(__doc__)
+    if argv[1] == "generate":
+        generate()
+    elif len(argv) < 3 or argv[2] == "-":
+        decode(sys.stdin.buffer)
+    else:
+        with open(argv[2], "rb") as f:
+            decode(f)
+
+
+if __name__ == "__main__":
+    main(sys.argv)
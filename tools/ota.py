@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Push firmware or LittleFS images to one or more ledbars over HTTP.
+
+  ota.py firmware.bin HOST [HOST...]         flash firmware
+  ota.py --fs littlefs.bin HOST [HOST...]    flash the filesystem image
+
+Images are gzip-compressed with a 4 KB window (the device inflates with
+GZIP_WINDOW_BITS 12, see src/GzipInflater.h) and sent to POST /update
+together with the MD5 of the uncompressed image. Already compressed .gz
+files are sent as is, but must have been made by this tool.
+"""
+import argparse
+import hashlib
+import json
+import struct
+import sys
+import urllib.request
+import uuid
+import zlib
+from concurrent.futures import ThreadPoolExecutor
+
+WINDOW_BITS = 12
+
+
+def gzip_compress(data):
+    compressor = zlib.compressobj(9, zlib.DEFLATED, -WINDOW_BITS, 9)
+    body = compressor.compress(data) + compressor.flush()
+    header = b"\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\xff"
+    trailer = struct.pack("<II", zlib.crc32(data) & 0xFFFFFFFF, len(data) & 0xFFFFFFFF)
+    return header + body + trailer
+
+
+def upload(host, payload, md5, filesystem, timeout):
+    boundary = uuid.uuid4().hex
+    body = (
+        f"--{boundary}\r\n"
+        f'Content-Disposition: form-data; name="image"; filename="image.gz"\r\n'
+        f"Content-Type: application/octet-stream\r\n\r\n"
+    ).encode() + payload + f"\r\n--{boundary}--\r\n".encode()
+    url = f"http://{host}/update?type={'filesystem' if filesystem else 'firmware'}&md5={md5}"
+    request = urllib.request.Request(url, data=body, method="POST")
+    request.add_header("Content-Type", f"multipart/form-data; boundary={boundary}")
+    try:
+        with urllib.request.urlopen(request, timeout=timeout) as response:
+            return host, True, json.loads(response.read() or b"{}")
+    except urllib.error.HTTPError as error:
+        return host, False, error.read().decode(errors="replace")
+    except OSError as error:
+        return host, False, str(error)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("image")
+    parser.add_argument("hosts", nargs="+")
+    parser.add_argument("--fs", action="store_true", help="image is a LittleFS filesystem")
+    parser.add_argument("--timeout", type=float, default=120)
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        data = f.read()
+    if data[:2] == b"\x1f\x8b":
+        payload = data
+        data = zlib.decompress(data, 16 + zlib.MAX_WBITS)
+    else:
+        payload = gzip_compress(data)
+    md5 = hashlib.md5(data).hexdigest()
+    print(f"{args.image}: {len(data)} bytes, {len(payload)} compressed, md5 {md5}")
+
+    failed = 0
+    with ThreadPoolExecutor(max_workers=8) as pool:
+        jobs = [pool.submit(upload, host, payload, md5, args.fs, args.timeout) for host in args.hosts]
+        for job in jobs:
+            host, ok, result = job.result()
+            print(f"{host}: {'ok' if ok else 'FAILED'} {result}")
+            failed += not ok
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())